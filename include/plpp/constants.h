@@ -5,7 +5,48 @@
 #define STARTING_WINDOW_HEIGHT 1080
 
 #define MAXIMUM_PARTICLE_TYPES 100
-#define MAXIMUM_PARTICLES 100000
 #define CONFIG_MATRIX_CELL_WIDTH 50
 #define CONFIG_MATRIX_CELL_HEIGHT 50
+
+// Particle buffers start this large and double whenever they run out of room
+#define INITIAL_PARTICLE_CAPACITY 4096
+// Position buffers cycled by the GPU backend, the step writing one slot overlaps the draw of another
+#define POSITION_RING_DEPTH 3
+// Validation counter buffers cycled by the GPU backend, one per batch of steps, read back once its fence signals
+#define VALIDATION_READBACK_LATENCY 3
+// Observable readback buffers cycled by the GPU backend, one per batch of steps, picked up once its fence signals
+#define OBSERVABLES_READBACK_SLOTS 4
+// Snapshot the simulator saves and loads with Ctrl + S and Ctrl + L
+#define SNAPSHOT_FILE "plpp_snapshot.bin"
+// Snapshot sections start on multiples of this many bytes, enough for any SIMD load
+#define SNAPSHOT_ALIGNMENT 64
+// Trajectory the simulator records while recording is enabled in the overlay
+#define TRAJECTORY_FILE "plpp_trajectory.bin"
+// Every this many frames a trajectory recording stores a frame that decodes on its own
+#define TRAJECTORY_KEYFRAME_INTERVAL 60
+// Smallest velocity range a trajectory keyframe quantizes, in pixels per second either way
+#define TRAJECTORY_MINIMUM_VELOCITY_RANGE 256.0f
+// Frames that can wait for the trajectory writer thread, further frames are dropped while it is behind
+#define TRAJECTORY_STAGING_FRAMES 4
+// Bytes of a trajectory the replay keeps faulted in ahead of the frame being shown
+#define TRAJECTORY_READAHEAD_BYTES (64ull << 20)
+// Particles with a smaller on-screen radius in pixels are drawn as single pixels
+#define PARTICLE_PIXEL_RADIUS 1.5f
+// Particles up to this on-screen radius in pixels are drawn as points, larger ones as quads
+#define PARTICLE_POINT_MAXIMUM_RADIUS 16.0f
+// Particles added by a shift + digit key press
+#define BULK_SPAWN_COUNT 10000
+
+// Upper bound on the spatial grid used to bin particles, cells grow past the
+// force radius when the display would otherwise need more than this
+#define GRID_MAXIMUM_CELLS 65536
+// Automatic kernel selection: a pair visited through the grid costs about this many
+// all-pairs pairs (scattered reads, binning), and below this many particles binning never pays
+#define GRID_PAIR_COST 2.0
+#define GRID_MINIMUM_PARTICLES 2048
+// Largest type count a force kernel variant is specialized for, the variant stages the
+// square of it as a force table in shared memory
+#define KERNEL_SPECIALIZED_TYPES 32
+// Frames the profiler panel averages its phase timings over
+#define PROFILER_HISTORY_FRAMES 120
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CPU_PHYSICS_ENGINE_H
+#define CPU_PHYSICS_ENGINE_H
+
+// Project Includes
+#include "plpp/interaction_kernel.h"
+#include "plpp/physics_engine.h"
+#include "plpp/thread_pool.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace PLPP
+{
+  // Headless reference backend, mirrors particles.comp step for step without needing a GL context.
+  // Steps run on a persistent work-stealing pool: each task owns a chunk of particles, reads the
+  // input positions and writes only its own slots of the output positions and velocities.
+  // Particles are stored as structure-of-arrays so the pair kernel can run vectorized.
+  class CPUPhysicsEngine : public PhysicsEngine
+  {
+  public:
+    // Particles (or grid slots) per task handed to the pool
+    int taskGrainSize = 256;
+
+    // threadCount <= 0 uses every hardware thread
+    explicit CPUPhysicsEngine(int threadCount = 0);
+    ~CPUPhysicsEngine() override = default;
+
+    void AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions, std::span<const glm::vec2> velocities = {}) override;
+    void SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display) override;
+    void ClearParticles() override;
+    void Update(float deltaTime, glm::ivec2 display) override;
+    void ReadParticles(std::vector<glm::vec2> &positions, std::vector<glm::vec2> &velocities, std::vector<int> &types) override;
+    size_t GetMemoryFootprint() const override;
+
+    // Halo particles exert forces on the particles during the next Update but are not stepped
+    // themselves. They are dropped by that Update and by any change to the particle set.
+    void SetHaloParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions);
+    int GetHaloCount() const { return haloCount_; }
+    // Removes the particles at the ascending ids, the remaining ones keep their order
+    void RemoveParticles(std::span<const int> ids);
+
+    // Replaces the pool, only meant to be called between steps
+    void SetThreadCount(int threadCount);
+    int GetThreadCount() const { return threadPool_->GetThreadCount(); }
+    const ThreadPool &GetThreadPool() const { return *threadPool_; }
+
+    // Falls back to the scalar kernel when the CPU lacks the requested instruction set
+    void SetKernelIsa(KernelIsa isa);
+    KernelIsa GetKernelIsa() const { return kernelIsa_; }
+
+  private:
+    std::unique_ptr<ThreadPool> threadPool_;
+    KernelIsa kernelIsa_;
+    // Instance for kernelIsa_ and the force law of the current step
+    InteractionKernelFunction kernel_;
+
+    std::vector<float> positionsInX_, positionsInY_, positionsOutX_, positionsOutY_;
+    std::vector<float> velocitiesX_, velocitiesY_;
+    std::vector<int> types_;
+    // Halo particles occupy the position and type slots past particleCount
+    int haloCount_ = 0;
+    uint64_t stepIndex_ = 0;
+
+    // Grows every particle array by count and returns the first new slot
+    int appendSlots(int count);
+
+    // Spatial grid, rebuilt every step with a counting sort
+    glm::ivec2 gridDimensions_;
+    std::vector<int> cellCounts_, cellStarts_, cellCursors_, particleCells_;
+    std::vector<int> sortedIds_, sortedTypes_;
+    std::vector<float> sortedX_, sortedY_;
+
+    void binParticles(glm::ivec2 display);
+    glm::vec2 gridForce(int slot) const;
+    glm::vec2 bruteForce(int id) const;
+    void integrate(int id, glm::vec2 finalForce, float deltaTime, float frictionFactor, glm::ivec2 display);
+    // Scalar reference of the observables particles.comp and observables.comp measure, run after
+    // the force pass while the input positions are still in place
+    void measureObservables(bool gridPass);
+  };
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+namespace PLPP
+{
+  // Turns variable frame times into a whole number of fixed-size simulation steps, so the
+  // simulation runs at its own rate regardless of the display refresh rate
+  class FixedTimestep
+  {
+  public:
+    int stepsPerSecond = 60;
+    // Steps run for a single frame at most, time beyond that is dropped so a slow frame cannot snowball
+    int maxSubsteps = 8;
+
+    // Accumulates the frame time and returns how many steps to run for it
+    int Advance(double frameSeconds);
+    void Reset() { accumulator_ = 0.0; }
+
+    float GetStepSeconds() const { return 1.0f / static_cast<float>(stepsPerSecond); }
+    // Fraction of a step left over after the last step, used to interpolate rendering
+    float GetAlpha() const;
+
+  private:
+    double accumulator_ = 0.0;
+  };
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef FORCE_LAW_H
+#define FORCE_LAW_H
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+
+namespace PLPP
+{
+  // How the force between two particles depends on their distance. The GPU kernels select the
+  // same law with FORCE_LAW, the CPU kernels are instantiated once per policy below.
+  enum class ForceLaw
+  {
+    // smoothstep(radius, radius / 100, dist), the original law
+    Smoothstep,
+    // Tom Mohr's piecewise-linear law: universal repulsion inside innerRadius, then a triangle
+    // peaking at the attraction halfway between innerRadius and radius
+    Beta,
+    // attraction * (innerRadius / dist)^2, saturating inside innerRadius and cut off at radius
+    InverseSquare
+  };
+
+  // Force law policies. Magnitude returns the signed force a neighbour at dist exerts, before the
+  // force multiplier, for 0 < dist < radius. attraction is the force matrix entry of the pair, laws
+  // leave the radii they do not depend on unnamed.
+
+  struct SmoothstepForceLaw
+  {
+    static float Magnitude(float attraction, float dist, float radius, float)
+    {
+      float t = std::clamp((dist - radius) / (radius / 100 - radius), 0.0f, 1.0f);
+      return attraction * (t * t * (3.0f - 2.0f * t));
+    }
+  };
+
+  struct BetaForceLaw
+  {
+    static float Magnitude(float attraction, float dist, float radius, float innerRadius)
+    {
+      if (dist < innerRadius)
+        return dist / innerRadius - 1.0f;
+      return attraction * (1.0f - std::abs(2.0f * dist - radius - innerRadius) / (radius - innerRadius));
+    }
+  };
+
+  struct InverseSquareForceLaw
+  {
+    static float Magnitude(float attraction, float dist, float, float innerRadius)
+    {
+      float ratio = std::min(innerRadius / dist, 1.0f);
+      return attraction * ratio * ratio;
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef GPU_PHYSICS_ENGINE_H
+#define GPU_PHYSICS_ENGINE_H
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/physics_engine.h"
+#include "plpp/shader.h"
+#include "plpp/spatial_grid.h"
+
+// External Libraries
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <vector>
+
+namespace PLPP
+{
+  // What the force pass does with a particle whose position or velocity stopped being finite
+  enum class InvalidParticlePolicy
+  {
+    // Count it and leave it alone
+    Report,
+    // Put it back at its previous position, at rest
+    Clamp,
+    // Move it to a random position, at rest
+    Respawn
+  };
+
+  // Outcome of the on-device validation of one batch of steps
+  struct ValidationResult
+  {
+    // Last step of the batch
+    uint64_t step = 0;
+    // Counted once for every step a particle was found invalid in
+    uint32_t invalidCount = 0;
+    // Lowest offending index, only meaningful when invalidCount > 0
+    uint32_t firstInvalid = 0;
+  };
+
+  // How well simulation steps overlap the draws reading earlier position slots
+  struct PipelineStatistics
+  {
+    int ringDepth = 0;
+    uint64_t steps = 0;
+    // Steps whose output slot was still being drawn, so the host had to wait
+    uint64_t stalledSteps = 0;
+    double stallSeconds = 0.0;
+    // Sum over steps of the draws still pending on the GPU when the step was issued
+    uint64_t framesInFlight = 0;
+
+    double GetOverlapRatio() const { return steps ? 1.0 - static_cast<double>(stalledSteps) / steps : 1.0; }
+    double GetAverageStallSeconds() const { return steps ? stallSeconds / steps : 0.0; }
+    double GetAverageFramesInFlight() const { return steps ? static_cast<double>(framesInFlight) / steps : 0.0; }
+  };
+
+  // OpenGL compute shader backend, particles live in persistently mapped SSBOs
+  class GPUPhysicsEngine : public PhysicsEngine
+  {
+  public:
+    InvalidParticlePolicy invalidParticlePolicy = InvalidParticlePolicy::Report;
+    // All-pairs steps stage tiles of particles in shared memory, off keeps the untiled reference kernel
+    bool useTiledKernel = true;
+    // Invocations per workgroup of the force kernels, a multiple of 32 up to 1024
+    int workgroupSize = 256;
+    // Build the force kernels for the types in use so their force matrix comes from shared memory,
+    // off uses the generic builds reading the whole matrix from its buffer
+    bool specializeKernels = true;
+
+    // positionRingDepth position buffers are cycled, at least two
+    explicit GPUPhysicsEngine(int positionRingDepth = POSITION_RING_DEPTH);
+    ~GPUPhysicsEngine() override;
+
+    void AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions, std::span<const glm::vec2> velocities = {}) override;
+    // Seeds positions and types on the device with seed.comp
+    void SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display) override;
+    // Waits for the draws still reading the particles
+    void ClearParticles() override;
+    void Update(float deltaTime, glm::ivec2 display) override;
+    // Issues all steps back to back, the per-step parameters are uploaded once
+    void Advance(float deltaTime, glm::ivec2 display, int steps) override;
+    // Grows the particle buffers to hold at least capacity particles, adding particles calls this on demand
+    void Reserve(int capacity);
+    int GetCapacity() const { return capacity_; }
+    void ReadParticles(std::vector<glm::vec2> &positions, std::vector<glm::vec2> &velocities, std::vector<int> &types) override;
+    size_t GetMemoryFootprint() const override;
+
+    float *GetForcesBuffer() override { return forcesPtr_; }
+    // Mapped palette read by particles.vert, recolouring a type is a single write
+    glm::vec4 *GetColorsBuffer() override { return palettePtr_; }
+    // Latest validation read back, up to VALIDATION_READBACK_LATENCY batches behind the simulation
+    const ValidationResult &GetLastValidation() const { return lastValidation_; }
+    GLuint GetParticlePositions() const { return positionSlots_[currentSlot_].buffer; }
+    // State before the last step, the current positions when no step ran since particles were added
+    GLuint GetPreviousParticlePositions() const
+    {
+      int depth = static_cast<int>(positionSlots_.size());
+      return positionSlots_[previousValid_ ? (currentSlot_ + depth - 1) % depth : currentSlot_].buffer;
+    }
+    GLuint GetParticleVelocities() const { return velocitySSBO_; }
+    GLuint GetParticleTypes() const { return typeSSBO_; }
+    // Steps issued since the backend was created
+    uint64_t GetStepCount() const { return stepIndex_; }
+    GLuint GetPalette() const { return paletteSSBO_; }
+    // Call after issuing a draw that reads the current or previous positions, neither will be
+    // overwritten before that draw completed
+    void FencePositions();
+    const PipelineStatistics &GetPipelineStatistics() const { return pipelineStatistics_; }
+    // Picks up the observables of every finished batch without waiting, steps call it as well
+    void PollObservables();
+
+  private:
+    GLuint velocitySSBO_ = 0, typeSSBO_ = 0, forcesSSBO_ = 0;
+    GLuint cellCountsSSBO_ = 0, cellStartsSSBO_ = 0, particleCellsSSBO_ = 0, sortedPositionsSSBO_ = 0, sortedTypesSSBO_ = 0;
+    GLuint paletteSSBO_ = 0;
+    // std140 mirror of the SimParams block in res/shaders/sim_params.glsl, uniform binding 0
+    struct SimParams
+    {
+      glm::ivec2 display{0, 0};
+      glm::ivec2 gridDimensions{0, 0};
+      glm::vec2 gridOrigin{0.0f, 0.0f};
+      float gridCellSize = 0.0f;
+      float delta = 0.0f;
+      float particleRadius = 0.0f;
+      float friction = 0.0f;
+      float gravityRadius = 0.0f;
+      float forceMultiplier = 0.0f;
+      int particleCount = 0;
+      int maxTypeCount = 0;
+      int invalidPolicy = 0;
+      float innerRadius = 0.0f;
+    };
+    static_assert(sizeof(SimParams) == 64, "SimParams must match the std140 block");
+    GLuint simParamsUBO_ = 0;
+    // Contents of simParamsUBO_, compared against to skip redundant uploads
+    SimParams simParams_;
+    glm::vec2 *velocitiesPtr_;
+    glm::vec4 *palettePtr_;
+    float *forcesPtr_;
+    int *typesPtr_;
+    int capacity_ = 0;
+
+    // Settings a force kernel is compiled for, each combination is its own program
+    enum class ForceKernel
+    {
+      Grid,
+      Tiled,
+      Brute
+    };
+    struct KernelVariant
+    {
+      ForceKernel kernel = ForceKernel::Grid;
+      // 0 for the generic build
+      int typeCount = 0;
+      int workgroupSize = 256;
+      BoundaryMode boundaryMode = BoundaryMode::Wrap;
+      int forceLaw = 0;
+      // Counts the pairs tested and in range, see collectObservables
+      bool observables = false;
+
+      auto operator<=>(const KernelVariant &) const = default;
+    };
+    std::map<KernelVariant, Shader> forceShaders_;
+    // Highest type id added so far plus one
+    int typeCount_ = 0;
+
+    Shader gridCountShader_;
+    Shader gridScanShader_;
+    Shader gridScatterShader_;
+    Shader seedShader_;
+    Shader observablesShader_;
+    // Every step reads the current slot and writes the next one, the fence guards the last draw of a slot
+    struct PositionSlot
+    {
+      GLuint buffer = 0;
+      glm::vec2 *pointer = nullptr;
+      GLsync fence = nullptr;
+    };
+    std::vector<PositionSlot> positionSlots_;
+    int currentSlot_ = 0;
+    bool previousValid_ = false;
+    PipelineStatistics pipelineStatistics_;
+    // Ring of counter buffers the force passes of a batch validate into, each read back once its
+    // fence signals
+    struct ValidationSlot
+    {
+      GLuint buffer = 0;
+      GLuint *counters = nullptr;
+      GLsync fence = nullptr;
+      uint64_t step = 0;
+    };
+    ValidationSlot validationSlots_[VALIDATION_READBACK_LATENCY];
+    ValidationResult lastValidation_;
+    uint64_t validationBatch_ = 0;
+    uint64_t stepIndex_ = 0;
+    // Host view of the Observables block of observables.comp
+    struct ObservableBlock
+    {
+      GLuint pairsTested[2];
+      GLuint pairsInRange[2];
+      float kineticEnergy;
+      GLuint reserved[3];
+      glm::vec4 typeSums[MAXIMUM_PARTICLE_TYPES];
+    };
+    static_assert(offsetof(ObservableBlock, typeSums) == 32, "ObservableBlock must match the std430 block");
+    // Ring of readback buffers the observables of the last step of a batch are reduced into
+    struct ObservableSlot
+    {
+      GLuint buffer = 0;
+      ObservableBlock *block = nullptr;
+      GLsync fence = nullptr;
+      uint64_t step = 0;
+      int particleCount = 0;
+      int typeCount = 0;
+    };
+    ObservableSlot observableSlots_[OBSERVABLES_READBACK_SLOTS];
+    uint64_t observableBatch_ = 0;
+    // Per-workgroup rows of the first reduction pass, grown on demand
+    GLuint observablePartialsSSBO_ = 0;
+    size_t observablePartialsSize_ = 0;
+    // Timestamps before binning, before and after the force pass
+    GLuint timerQueries_[3];
+
+    // Rewrites the uniform block only if a parameter changed, then binds it
+    void uploadSimParams(const SimParams &params);
+    void binParticles();
+    KernelVariant selectVariant(bool gridPass) const;
+    // Builds the variant on first request, the link finishes on its first use
+    Shader &getForceShader(const KernelVariant &variant);
+    // Starts building the variants the next step may pick, so it does not wait for the compiler
+    void prepareForceShaders();
+    void collectStepStatistics(glm::ivec2 gridDimensions);
+    // Reads back every finished batch and binds the slot of the next one, never waits
+    void beginValidation();
+    void readValidation(ValidationSlot &slot);
+    // Resets and binds the slot of the next batch's observables, false when the ring is full
+    bool beginObservables();
+    // Reduces the kinetic energy and type centroids of the step just issued into its slot
+    void reduceObservables(GLuint positions);
+    void readObservables(ObservableSlot &slot);
+    // Waits for the draw still reading the slot, if any, and records whether the step stalled
+    void acquireSlot(PositionSlot &slot);
+  };
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+// Project Includes
+#include "plpp/profiler.h"
+
+// External Libraries
+#include <glad/glad.h>
+
+// C++ Standard Library
+#include <cstdint>
+#include <vector>
+
+#ifdef PLPP_PROFILING
+// Times the GL commands issued in the rest of the block with a GL_TIME_ELAPSED query
+#define PLPP_PROFILE_GPU_SCOPE(name) ::PLPP::GPUProfileScope PLPP_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PLPP_PROFILE_GPU_END_FRAME() ::PLPP::GPUProfiler::EndFrame()
+#else
+#define PLPP_PROFILE_GPU_SCOPE(name) ((void)0)
+#define PLPP_PROFILE_GPU_END_FRAME() ((void)0)
+#endif
+
+namespace PLPP
+{
+  // Timer queries of the GPU scopes, double buffered on the frame parity: the queries of a frame
+  // are read back at the end of the next one, by when they have normally finished. Results still
+  // pending then are dropped instead of waiting for them. Only used on the GL context's thread.
+  class GPUProfiler
+  {
+  public:
+    // Hands the previous frame's results to the Profiler, call before Profiler::EndFrame
+    static void EndFrame();
+    // Queries whose results were not ready in time
+    static uint64_t GetDroppedCount() { return dropped_; }
+
+  private:
+    friend class GPUProfileScope;
+
+    struct PendingQuery
+    {
+      GLuint query;
+      const char *name;
+      double start;
+    };
+
+    static std::vector<GLuint> queries_[2];
+    static std::vector<PendingQuery> pending_[2];
+    static int parity_;
+    // GL_TIME_ELAPSED queries can't nest, inner scopes are skipped
+    static bool inScope_;
+    static uint64_t dropped_;
+
+    GPUProfiler() {}
+  };
+
+  class GPUProfileScope
+  {
+  public:
+    explicit GPUProfileScope(const char *name);
+    ~GPUProfileScope();
+
+  private:
+    bool active_;
+
+    GPUProfileScope(const GPUProfileScope &) = delete;
+    GPUProfileScope &operator=(const GPUProfileScope &) = delete;
+  };
+}
+
+#endif
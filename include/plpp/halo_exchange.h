@@ -0,0 +1,100 @@
+#ifndef HALO_EXCHANGE_H
+#define HALO_EXCHANGE_H
+
+// C++ Standard Library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace PLPP
+{
+  // A particle crossing between workers, the global id survives any number of migrations
+  struct ParticleRecord
+  {
+    float x, y;
+    float vx, vy;
+    int type;
+    int id;
+  };
+
+  // Written by each worker once its run has finished
+  struct WorkerReport
+  {
+    int particleCount;
+    double stepSeconds;
+    // Spent classifying, waiting for the neighbours and applying what they sent
+    double exchangeSeconds;
+    uint64_t migrants;
+    uint64_t haloParticles;
+  };
+
+  // Shared memory segment the worker processes of one run communicate through. Every worker owns
+  // an outgoing mailbox per direction around the ring, holding the particles that migrate to that
+  // neighbour followed by the halo particles it needs. Mailboxes are double buffered on the step
+  // parity, so a single barrier per step separates writing them from reading them.
+  class HaloExchange
+  {
+  public:
+    enum class Direction
+    {
+      Left,
+      Right
+    };
+
+    struct Mailbox
+    {
+      int migrantCount;
+      int haloCount;
+      ParticleRecord *records;
+    };
+
+    // Maps an anonymous segment for workerCount workers, each mailbox holding capacity records.
+    // Must be created before forking the workers, which inherit the mapping. Returns nullptr
+    // and reports the error when the segment can't be created.
+    static std::unique_ptr<HaloExchange> Create(int workerCount, int capacity);
+    ~HaloExchange();
+
+    int GetWorkerCount() const { return workerCount_; }
+    int GetCapacity() const { return capacity_; }
+
+    // Mailbox rank writes for its neighbour in direction during steps of the given parity
+    Mailbox GetMailbox(int rank, Direction direction, int parity) const;
+    void PostMailbox(int rank, Direction direction, int parity, int migrantCount, int haloCount);
+
+    // Blocks until every worker has arrived, returns false once any worker has aborted
+    bool Arrive();
+    // Releases the other workers from Arrive, which fail from then on
+    void Abort();
+    bool IsAborted() const;
+
+    // Appends a worker's final particles to the shared result
+    void Gather(std::span<const ParticleRecord> particles);
+    std::span<const ParticleRecord> GetGathered() const;
+    WorkerReport &GetReport(int rank) const;
+
+  private:
+    struct Header;
+
+    void *segment_;
+    size_t segmentSize_;
+    int workerCount_;
+    int capacity_;
+
+    Header *header_;
+    WorkerReport *reports_;
+    // [parity][rank][direction] counts and records
+    int *mailboxCounts_;
+    ParticleRecord *mailboxRecords_;
+    ParticleRecord *gathered_;
+
+    HaloExchange() {}
+    HaloExchange(const HaloExchange &) = delete;
+    HaloExchange &operator=(const HaloExchange &) = delete;
+
+    size_t getMailboxIndex(int rank, Direction direction, int parity) const;
+  };
+}
+
+#endif
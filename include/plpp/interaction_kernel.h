@@ -0,0 +1,82 @@
+#ifndef INTERACTION_KERNEL_H
+#define INTERACTION_KERNEL_H
+
+// Project Includes
+#include "plpp/force_law.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <string>
+#include <vector>
+
+namespace PLPP
+{
+  // Inputs of the pair interaction body of particles.comp, over structure-of-arrays storage
+  struct InteractionKernelArgs
+  {
+    // Neighbour positions and type ids
+    const float *x;
+    const float *y;
+    const int *types;
+    // Forces felt by the target's type, indexed by the neighbour's type id
+    const float *forceRow;
+    float targetX;
+    float targetY;
+    // Index of the target itself within the neighbour arrays, never interacts with itself
+    int targetIndex;
+    float radius;
+    float forceMultiplier;
+    // See ForceLaw, only read by the laws that use it
+    float innerRadius;
+  };
+
+  // Sums the force every neighbour in [begin, end) exerts on the target
+  using InteractionKernelFunction = glm::vec2 (*)(const InteractionKernelArgs &args, int begin, int end);
+
+  enum class KernelIsa
+  {
+    Scalar,
+    AVX2,
+    AVX512
+  };
+
+  // Runtime dispatch between the instruction set variants of the pair kernel
+  class InteractionKernel
+  {
+  public:
+    static KernelIsa GetBestIsa();
+    static bool IsSupported(KernelIsa isa);
+    static std::vector<KernelIsa> GetSupportedIsas();
+    static InteractionKernelFunction Get(KernelIsa isa, ForceLaw law = ForceLaw::Smoothstep);
+    static std::string GetName(KernelIsa isa);
+
+  private:
+    InteractionKernel() {}
+  };
+
+  // Each kernel is a template over a force law policy from force_law.h, so every law gets its own
+  // fully inlined loop. The instantiations live next to the definitions.
+  template <typename Law>
+  glm::vec2 AccumulateForcesScalar(const InteractionKernelArgs &args, int begin, int end);
+#ifdef PLPP_X86_KERNELS
+  // What the instruction set specific kernels return. Their files are compiled with -mavx2 or
+  // -mavx512f, an inline glm function used there could be emitted with those instructions and
+  // picked by the linker for the whole program, so they don't touch glm at all.
+  struct KernelForce
+  {
+    float x;
+    float y;
+  };
+
+  // Only covers whole groups of 8 neighbours, InteractionKernel::Get adds the scalar tail
+  template <typename Law>
+  KernelForce AccumulateForcesAVX2(const InteractionKernelArgs &args, int begin, int end);
+  // Masks the tail itself
+  template <typename Law>
+  KernelForce AccumulateForcesAVX512(const InteractionKernelArgs &args, int begin, int end);
+#endif
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// C++ Standard Library
+#include <cstddef>
+#include <filesystem>
+
+namespace PLPP
+{
+  // Read-only mapping of a whole file, unmapped when it goes out of scope
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::filesystem::path &path);
+    void Close();
+    bool IsOpen() const { return data_ != nullptr; }
+
+    const unsigned char *GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+    // Asks the OS to start reading the range in the background, returns right away
+    void Prefetch(size_t offset, size_t length) const;
+    // Faults the range in by reading a byte of every page, waits for the disk where needed
+    void Touch(size_t offset, size_t length) const;
+    // Pages of the range may be dropped from memory, they are read again on the next access
+    void Release(size_t offset, size_t length) const;
+
+  private:
+    const unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+  };
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+// Project Includes
+#include "plpp/physics_engine.h"
+
+// C++ Standard Library
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace PLPP
+{
+  // Appends StepObservables to a CSV file, one row per type and step so the type count may change
+  // during a run. The step-wide columns repeat on every row of a step.
+  class MetricsWriter
+  {
+  public:
+    // Truncates the file and writes the header, false if it can't be opened
+    bool Open(const std::filesystem::path &path);
+    void Close() { file_.close(); }
+    bool IsOpen() const { return file_.is_open(); }
+
+    // Observables of a step already written are skipped, so callers can hand in the latest ones every frame
+    void Write(const StepObservables &observables);
+
+  private:
+    std::ofstream file_;
+    uint64_t lastStep_ = 0;
+  };
+}
+
+#endif
@@ -2,7 +2,10 @@
 #define OVERLAY_H
 
 // Project Includes
+#include "plpp/fixed_timestep.h"
 #include "plpp/physics_engine.h"
+#include "plpp/shader.h"
+#include "plpp/trajectory_recorder.h"
 
 // External Libraries
 #include <glad/glad.h>
@@ -13,24 +16,55 @@ namespace PLPP
   class Overlay
   {
   public:
-    Overlay(GLFWwindow *window, PhysicsEngine &physicsEngine_);
+    Overlay(GLFWwindow *window, PhysicsEngine &physicsEngine_, FixedTimestep &timestep);
     ~Overlay();
 
     bool mainMenuBarEnabled = true;
     bool settingsAndConfigsMenuEnabled = false;
+    bool profilerMenuEnabled = false;
+    // Picked from the particles' on-screen radius unless turned off, the simulator writes the pick back
+    bool particlePrimitiveAuto = true;
+    ParticlePrimitive particlePrimitive = ParticlePrimitive::Quads;
+    // Step the CPU backend on a thread of its own instead of the GPU backend between frames
+    bool simulationThreadEnabled = false;
+
+    // Refreshed by the simulator every frame
+    double frameRate = 0.0;
+    double stepRate = 0.0;
+    int particleCount = 0;
+    // Measure the observables of every step, optionally appending them to plpp_metrics.csv
+    bool observablesEnabled = false;
+    bool metricsFileEnabled = false;
+    StepObservables observables;
+    // Record every recordInterval-th step to TRAJECTORY_FILE
+    bool recordingEnabled = false;
+    int recordInterval = 1;
+    TrajectoryStatistics recording;
+    // Play TRAJECTORY_FILE back instead of simulating, the scrubber moves replayPlayhead and
+    // raises replaySeekRequested, the simulator writes the playhead back every frame
+    bool replayEnabled = false;
+    bool replayPaused = false;
+    float replaySpeed = 1.0f;
+    double replayPlayhead = 0.0;
+    bool replaySeekRequested = false;
+    uint64_t replayFirstStep = 0, replayLastStep = 0;
 
     void Render();
 
   private:
     GLFWwindow *window;
     PhysicsEngine &physicsEngine_;
+    FixedTimestep &timestep_;
     
 
     void showMainMenuBar();
     void showSettingsAndConfigsMenu();
+    void showProfilerMenu();
 
     void configurationMenu();
     void settingsMenu();
+    void observablesMenu();
+    void recordingMenu();
   };
 }
 
@@ -3,18 +3,64 @@
 
 // Project Includes
 #include "constants.h"
-#include "plpp/shader.h"
+#include "plpp/force_law.h"
+#include "plpp/spatial_grid.h"
+#include "plpp/spawn_distribution.h"
 
 // External Libraries
-#include <glad/glad.h>
-#include <glfw/glfw3.h>
 #include <glm/glm.hpp>
 
 // C++ Standard Library
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 namespace PLPP
 {
+  // Cost breakdown of the last Update, only filled while collectStatistics is set
+  struct StepStatistics
+  {
+    // Pair bodies evaluated, including the ones rejected by the radius test
+    uint64_t pairsTested = 0;
+    double binningSeconds = 0.0;
+    double forceSeconds = 0.0;
+  };
+
+  // Physical observables after one step, only measured while collectObservables is set. Used to
+  // spot density hot spots and to check that a faster kernel still steps the same physics.
+  struct StepObservables
+  {
+    // Steps the backend had taken when the observables were measured, 0 before the first one
+    uint64_t step = 0;
+    int particleCount = 0;
+    // Pair bodies evaluated, including the ones rejected by the radius test
+    uint64_t pairsTested = 0;
+    // Pairs closer than the force radius, counted once from each side
+    uint64_t pairsInRange = 0;
+    // Sum of |v|^2 / 2, every particle has unit mass
+    double kineticEnergy = 0.0;
+    // Indexed by type id, types without particles have a zero centroid
+    std::vector<int> typeCounts;
+    std::vector<glm::vec2> typeCentroids;
+
+    double GetMeanNeighbours() const { return particleCount ? static_cast<double>(pairsInRange) / particleCount : 0.0; }
+  };
+
+  // What happens to a particle leaving the display
+  enum class BoundaryMode
+  {
+    // Re-enters on the opposite side
+    Wrap,
+    // Stops at the edge, losing its velocity across it
+    Clamp,
+    // Bounces off the edge
+    Reflect
+  };
+
+  // Common interface of the simulation backends. Holds the parameters shared by every
+  // backend, the backends own the particle storage and the stepping.
   class PhysicsEngine
   {
   public:
@@ -24,35 +70,126 @@ namespace PLPP
     float particleRadius = 5.0f;
     float forceMultiplier = 10.0f;
     float effectiveForceRadius = 50.0f;
+    BoundaryMode boundaryMode = BoundaryMode::Wrap;
+    ForceLaw forceLaw = ForceLaw::Smoothstep;
+    // Share of effectiveForceRadius the Beta and InverseSquare laws use as their inner radius
+    float forceLawInnerRadius = 0.3f;
+    // Bin particles into a uniform grid so each particle only visits its 3x3 neighbouring cells.
+    // Disabling falls back to the brute-force O(N^2) kernel, which is kept as a reference.
+    bool useSpatialGrid = true;
+    // Ignore useSpatialGrid and pick the grid or the all-pairs kernel every step from the force
+    // radius and particle count, assuming an even spread, see PrefersSpatialGrid
+    bool autoSelectKernel = false;
+    // Measure every step into GetLastStepStatistics, may synchronize with the device
+    bool collectStatistics = false;
+    // Measure the observables of every step into GetLastObservables, the GPU backend only measures
+    // the last step of each Advance
+    bool collectObservables = false;
 
-    std::vector<glm::vec4> colors;
     std::vector<glm::vec4> particleColors = std::vector<glm::vec4>(MAXIMUM_PARTICLE_TYPES, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
     std::vector<float> forceMatrix = std::vector<float>(MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES);
 
-    PhysicsEngine(Shader computeShader);
-    ~PhysicsEngine() = default;
+    virtual ~PhysicsEngine() = default;
 
-    void AddParticle(int typeId, glm::vec2 position, glm::vec2 velocity);
-    void Update(float deltaTime, GLFWwindow *window);
-    void UpdateColors();
+    // Appends particles in one go, an empty velocities span leaves them at rest
+    virtual void AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions, std::span<const glm::vec2> velocities = {}) = 0;
+    // Appends distribution.count particles sampled over the display
+    virtual void SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display) = 0;
+    void AddParticle(int typeId, glm::vec2 position, glm::vec2 velocity) { AddParticles({&typeId, 1}, {&position, 1}, {&velocity, 1}); }
+    // Removes every particle, parameters and the force matrix stay
+    virtual void ClearParticles() = 0;
+    // Advances the simulation by deltaTime, particles at the display bounds follow boundaryMode
+    virtual void Update(float deltaTime, glm::ivec2 display) = 0;
+    // Runs steps fixed-size steps, backends may batch them
+    virtual void Advance(float deltaTime, glm::ivec2 display, int steps)
+    {
+      for (int step = 0; step < steps; step++)
+        Update(deltaTime, display);
+    }
+    // Copies the current particle state into host memory, waiting for pending work if required
+    virtual void ReadParticles(std::vector<glm::vec2> &positions, std::vector<glm::vec2> &velocities, std::vector<int> &types) = 0;
 
     // Represents "particle <x> feels a force of [x,y] from particle <y>"
     // index calculation = length * x + y
-    float &GetForceValue(int typeIdActed, int typeIdActing) { return forceMatrix[typeIdActed * MAXIMUM_PARTICLE_TYPES + typeIdActing]; }
-    float *GetForcesBuffer() const { return forcesPtr_; }
-    GLuint GetParticlePositions() const { return positionsInSSBO_; }
-    void SetFence(GLsync &fence) { swapFence_ = fence; }
-
-  private:
-    GLuint positionsInSSBO_, positionsOutSSBO_, velocitySSBO_, typeSSBO_, forcesSSBO_;
-    glm::vec2 *positionsInPtr_, *positionsOutPtr_, *velocitiesPtr_;
-    float *forcesPtr_;
-    int *typesPtr_;
-
-    Shader computeShader_;
-    std::vector<glm::vec4 *> colorPointers_;
-    GLsync swapFence_ = nullptr;
+    float &GetForceValue(int typeIdActed, int typeIdActing) { return GetForcesBuffer()[typeIdActed * MAXIMUM_PARTICLE_TYPES + typeIdActing]; }
+    virtual float *GetForcesBuffer() { return forceMatrix.data(); }
+    // Per-type palette, a backend that renders may store it where the renderer reads it directly
+    glm::vec4 &GetParticleColor(int typeId) { return GetColorsBuffer()[typeId]; }
+    virtual glm::vec4 *GetColorsBuffer() { return particleColors.data(); }
+    // Bytes held by the backend for particle, grid and parameter storage
+    virtual size_t GetMemoryFootprint() const = 0;
+    const StepStatistics &GetLastStepStatistics() const { return lastStepStatistics_; }
+    // Latest observables measured, backends that read them back asynchronously lag a few steps behind
+    const StepObservables &GetLastObservables() const { return lastObservables_; }
+
+    // The 3x3 neighbourhood the grid kernel scans shrinks relative to the world as the force radius
+    // does, once it covers a large part of it the binning costs more than it saves. Density is only
+    // taken as the mean over the display: the estimate assumes the particles spread evenly, so a
+    // dense cluster in a large world still picks the grid even though its few occupied cells test
+    // nearly every pair. Measuring the occupancy would need the cell counts back from the device
+    // before every step.
+    bool PrefersSpatialGrid(glm::ivec2 display) const
+    {
+      SpatialGrid grid = SpatialGrid::Fit(display, particleRadius, effectiveForceRadius);
+      double neighbourhood = std::min(1.0, 9.0 / grid.GetCellCount());
+      return particleCount >= GRID_MINIMUM_PARTICLES && neighbourhood * GRID_PAIR_COST < 1.0;
+    }
+    bool UsesSpatialGrid(glm::ivec2 display) const { return autoSelectKernel ? PrefersSpatialGrid(display) : useSpatialGrid; }
+    // Inner radius of the force law in pixels, kept strictly inside the force radius
+    float GetForceInnerRadius() const { return effectiveForceRadius * std::clamp(forceLawInnerRadius, 0.01f, 0.99f); }
+
+    // Copies the simulation parameters and force matrix (not the particles) from another backend
+    void CopyParameters(PhysicsEngine &other)
+    {
+      friction = other.friction;
+      particleRadius = other.particleRadius;
+      forceMultiplier = other.forceMultiplier;
+      effectiveForceRadius = other.effectiveForceRadius;
+      boundaryMode = other.boundaryMode;
+      forceLaw = other.forceLaw;
+      forceLawInnerRadius = other.forceLawInnerRadius;
+      useSpatialGrid = other.useSpatialGrid;
+      autoSelectKernel = other.autoSelectKernel;
+      collectObservables = other.collectObservables;
+      std::copy(other.GetColorsBuffer(), other.GetColorsBuffer() + MAXIMUM_PARTICLE_TYPES, GetColorsBuffer());
+      std::copy(other.GetForcesBuffer(), other.GetForcesBuffer() + MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES, GetForcesBuffer());
+    }
+
+  protected:
+    StepStatistics lastStepStatistics_;
+    StepObservables lastObservables_;
+
+    // Type ids index the force matrix, AddParticles rejects a batch with any outside it
+    static bool hasValidTypes(std::span<const int> typeIds)
+    {
+      return std::all_of(typeIds.begin(), typeIds.end(), [](int type)
+                         { return type >= 0 && type < MAXIMUM_PARTICLE_TYPES; });
+    }
+
+    // Pair bodies a grid step evaluates: every particle scans all slots of its 3x3 neighbourhood
+    template <typename Count>
+    static uint64_t countGridPairs(const Count *cellCounts, glm::ivec2 gridDimensions)
+    {
+      uint64_t pairs = 0;
+      for (int cy = 0; cy < gridDimensions.y; cy++)
+      {
+        for (int cx = 0; cx < gridDimensions.x; cx++)
+        {
+          uint64_t occupants = cellCounts[cy * gridDimensions.x + cx];
+          if (occupants == 0)
+            continue;
+          uint64_t neighbours = 0;
+          for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, gridDimensions.y - 1); ny++)
+          {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, gridDimensions.x - 1); nx++)
+              neighbours += cellCounts[ny * gridDimensions.x + nx];
+          }
+          pairs += occupants * neighbours;
+        }
+      }
+      return pairs;
+    }
   };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,103 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Project Includes
+#include "plpp/constants.h"
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Instrumentation is only compiled in with PLPP_PROFILING, otherwise the macros expand to nothing
+#define PLPP_PROFILE_CONCAT_INNER(a, b) a##b
+#define PLPP_PROFILE_CONCAT(a, b) PLPP_PROFILE_CONCAT_INNER(a, b)
+#ifdef PLPP_PROFILING
+// Times the rest of the enclosing block, name must outlive the profiler (a literal or Profiler::Intern)
+#define PLPP_PROFILE_SCOPE(name) ::PLPP::ProfileScope PLPP_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PLPP_PROFILE_END_FRAME() ::PLPP::Profiler::EndFrame()
+#else
+#define PLPP_PROFILE_SCOPE(name) ((void)0)
+#define PLPP_PROFILE_END_FRAME() ((void)0)
+#endif
+
+namespace PLPP
+{
+  // One timed scope, times in seconds since the profiler started
+  struct ProfileEvent
+  {
+    const char *name;
+    double start;
+    double duration;
+    int threadId;
+    int depth;
+    bool gpu;
+  };
+
+  // Rolling timings of every scope name over the last PROFILER_HISTORY_FRAMES frames. A name
+  // entered several times in a frame counts with the sum of its durations.
+  struct PhaseStatistics
+  {
+    const char *name;
+    bool gpu;
+    double lastSeconds;
+    double averageSeconds;
+    double maximumSeconds;
+  };
+
+  // Collects the scopes of all threads frame by frame. Can also capture a number of frames into a
+  // Chrome trace (chrome://tracing, ui.perfetto.dev). GPU scopes are recorded by GPUProfileScope.
+  class Profiler
+  {
+  public:
+    // Runtime switch, scopes cost one relaxed load while it is off. Off by default, tools that
+    // never end a frame would otherwise pile up events.
+    static std::atomic<bool> Enabled;
+
+    // Folds the frame's events into the phase statistics, called once per rendered frame
+    static void EndFrame();
+    static std::vector<PhaseStatistics> GetPhases();
+
+    // Records the next frameCount frames and writes them to path as trace JSON once they are done
+    static void CaptureTrace(int frameCount, std::filesystem::path path);
+    static bool IsCapturing();
+    // Path of the last trace written, empty if none
+    static std::filesystem::path GetLastTrace();
+
+    // Stable copy of name, for scope names that are built at runtime
+    static const char *Intern(std::string_view name);
+
+    static double GetSeconds() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_).count(); }
+    static void Record(const ProfileEvent &event);
+    // Small id of the calling thread, the tid of its trace track
+    static int GetThreadId();
+
+  private:
+    static const std::chrono::steady_clock::time_point epoch_;
+
+    Profiler() {}
+    static bool writeTrace(const std::filesystem::path &path, const std::vector<ProfileEvent> &events);
+  };
+
+  class ProfileScope
+  {
+  public:
+    explicit ProfileScope(const char *name);
+    ~ProfileScope();
+
+  private:
+    const char *name_;
+    double start_;
+    int depth_;
+    bool active_;
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+  };
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef RATE_COUNTER_H
+#define RATE_COUNTER_H
+
+// C++ Standard Library
+#include <atomic>
+#include <chrono>
+
+namespace PLPP
+{
+  // Events per second averaged over windows of half a second. One thread ticks, any thread may
+  // read the rate.
+  class RateCounter
+  {
+  public:
+    // Records count events, a zero count still closes the window so an idle rate drops to zero
+    void Tick(int count = 1)
+    {
+      auto now = std::chrono::steady_clock::now();
+      events_ += count;
+      double elapsed = std::chrono::duration<double>(now - windowStart_).count();
+      if (elapsed >= 0.5)
+      {
+        rate_.store(events_ / elapsed, std::memory_order_relaxed);
+        events_ = 0;
+        windowStart_ = now;
+      }
+    }
+
+    double GetRate() const { return rate_.load(std::memory_order_relaxed); }
+
+  private:
+    std::chrono::steady_clock::time_point windowStart_ = std::chrono::steady_clock::now();
+    int events_ = 0;
+    std::atomic<double> rate_ = 0.0;
+  };
+}
+
+#endif
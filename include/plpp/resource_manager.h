@@ -5,27 +5,52 @@
 #include "plpp/shader.h"
 
 // C++ Standard Library
+#include <cstdint>
+#include <filesystem>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace PLPP
 {
+  // Preprocessor values a shader variant is built with, e.g. {"WORKGROUP_SIZE", 128}
+  using ShaderDefines = std::map<std::string, int>;
+
   class ResourceManager
   {
   public:
     static std::map<std::string, Shader> Shaders;
+    // Linked programs are kept here between runs, keyed on their sources and the driver. Empty disables the cache.
+    static std::filesystem::path ProgramCacheDirectory;
 
-    static Shader LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name);
-    static Shader LoadShader(const char *cShaderFile, std::string name);
+    // Defines are inserted right after the #version line, name has to tell the variants apart
+    static Shader LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name, const ShaderDefines &defines = {});
+    static Shader LoadShader(const char *cShaderFile, std::string name, const ShaderDefines &defines = {});
+    // For compute shaders not needed right away, their link finishes on first use, see Shader(const char *, bool)
+    static Shader LoadDeferredShader(const char *cShaderFile, std::string name, const ShaderDefines &defines = {});
     static void Clear();
+    // Writes the binaries of deferred programs linked from source, waits for any still compiling
+    static void StoreProgramBinaries();
 
     static Shader GetShader(std::string name) { return Shaders.at(name); };
     
 
   private:
+    struct PendingBinary
+    {
+      std::filesystem::path path;
+      unsigned int program;
+    };
+    static std::vector<PendingBinary> pendingBinaries_;
+
     ResourceManager() {}
-    static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile);
-    static Shader loadShaderFromFile(const char *cShaderFile);
+    static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const std::string &name, const ShaderDefines &defines);
+    static Shader loadShaderFromFile(const char *cShaderFile, const std::string &name, const ShaderDefines &defines, bool deferred);
+    // Cache file for the given sources on the current driver, empty when caching is unavailable
+    static std::filesystem::path programBinaryPath(const std::string &name, std::initializer_list<const std::string *> sources);
+    // Creates a program from a cached binary, 0 when there is none or the driver rejects it
+    static unsigned int loadProgramBinary(const std::filesystem::path &path);
+    static void storeProgramBinary(const std::filesystem::path &path, unsigned int program);
   };
 }
 
@@ -0,0 +1,41 @@
+#ifndef SCALING_REPORT_H
+#define SCALING_REPORT_H
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace PLPP
+{
+  struct ScalingSample
+  {
+    int threadCount;
+    double secondsPerStep;
+    // Relative to the first sample, which should be the single threaded run
+    double speedup;
+    double efficiency;
+    uint64_t steals;
+  };
+
+  // Strong scaling study of the CPU backend: the same world is stepped with each thread count
+  class ScalingReport
+  {
+  public:
+    static std::vector<ScalingSample> Measure(CPUPhysicsEngine &engine, glm::ivec2 display, float deltaTime, int steps, const std::vector<int> &threadCounts);
+    // Thread counts 1, 2, 4, ... up to and including maxThreads
+    static std::vector<int> PowersOfTwo(int maxThreads);
+    static void Print(std::ostream &out, const std::vector<ScalingSample> &samples);
+
+  private:
+    ScalingReport() {}
+  };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/physics_engine.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace PLPP
+{
+  // World description for headless runs. Plain "key = value" text, '#' starts a comment:
+  //   width = 1920                  display the particles wrap around
+  //   height = 1080
+  //   friction = 0.7
+  //   particleRadius = 5
+  //   forceMultiplier = 10
+  //   effectiveForceRadius = 50
+  //   spatialGrid = 1
+  //   particles = 1000 1000 500     particle count per type, also sets the type count
+  //   randomForces = 1              fill the force matrix from the seed instead of rows
+  //   forces 0 = 0.5 -0.2 0.1       force row of type 0, one value per acting type
+  struct Scenario
+  {
+    glm::ivec2 display = glm::ivec2(STARTING_WINDOW_WIDTH, STARTING_WINDOW_HEIGHT);
+    float friction = 0.7f;
+    float particleRadius = 5.0f;
+    float forceMultiplier = 10.0f;
+    float effectiveForceRadius = 50.0f;
+    bool useSpatialGrid = true;
+    bool randomForces = false;
+    std::vector<int> particlesPerType;
+    std::vector<float> forceMatrix = std::vector<float>(MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES);
+
+    int GetTypeCount() const { return static_cast<int>(particlesPerType.size()); }
+    int GetParticleCount() const;
+
+    // Returns false and reports the offending line when the file can't be used
+    static bool Load(const std::string &path, Scenario &scenario);
+
+    // Copies the parameters and force matrix into the engine, randomizing forces first when requested
+    void Apply(PhysicsEngine &engine, uint64_t seed);
+    // Spawns every particle at a uniformly random position with zero velocity
+    void Spawn(PhysicsEngine &engine, uint64_t seed) const;
+  };
+}
+
+#endif
@@ -8,26 +8,56 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // C++ Standard Library
+#include <functional>
+#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace PLPP
 {
+  // How Render rasterizes the particles, a program has to be built with the matching
+  // PARTICLE_PRIMITIVE define
+  enum class ParticlePrimitive
+  {
+    // Two triangles per particle, for particles larger than the driver's points
+    Quads,
+    // One point per particle sized to its diameter
+    Points,
+    // A single pixel per particle, for particles smaller than one
+    Pixels
+  };
+
   class Shader
   {
   public:
     unsigned int ID;
+    // Shown in profiles, ResourceManager sets it to an interned copy of the shader's name
+    const char *Name = "Shader";
 
     Shader(const char *vertexSource, const char *fragmentSource);
-    Shader(const char *computeSource);
+    // A deferred link returns as soon as compiling and linking are issued, the driver may finish them
+    // in the background. Errors are reported and uniforms resolved on the first Use().
+    Shader(const char *computeSource, bool deferLink = false);
+    // Wraps a program that is already linked, e.g. one restored from a program binary
+    static Shader FromProgram(unsigned int program, bool renderProgram);
     Shader &Use();
 
-    void Render(GLFWwindow *window, const unsigned int positions, const float radius, const std::vector<glm::vec4> colors, const int particleCount);
+    // Colours come from the palette buffer, indexed by each particle's type. Particles are drawn
+    // at alpha between previousPositions and positions. The vertices are pulled from the buffers
+    // by gl_VertexID, nothing but an empty vertex array is bound.
+    void Render(GLFWwindow *window, const unsigned int positions, const unsigned int previousPositions, const unsigned int types, const unsigned int palette,
+                const float radius, const float alpha, const int particleCount, ParticlePrimitive primitive = ParticlePrimitive::Quads);
     void Dispatch(int groups);
 
+    // Location cached when the program was linked, -1 for unknown names and block members
+    GLint GetUniformLocation(std::string_view name) const;
+
     void SetBool(const char *name, bool value, bool useShader = false);
     void SetFloat(const char *name, float value, bool useShader = false);
     void SetInteger(const char *name, int value, bool useShader = false);
+    void SetUnsigned(const char *name, unsigned int value, bool useShader = false);
+    void SetFloats(const char *name, const float *values, int count, bool useShader = false);
     void SetVec2f(const char *name, float x, float y, bool useShader = false);
     void SetVec2f(const char *name, const glm::vec2 &value, bool useShader = false);
     void SetVec3f(const char *name, float x, float y, float z, bool useShader = false);
@@ -51,14 +81,19 @@ namespace PLPP
     };
 
     ShaderType type_;
+    bool linkPending_ = false;
     GLFWwindow *window_;
-    unsigned int quadVAO_;
-    unsigned int positionInstanceVBO_;
-    unsigned int colorInstanceVBO_;
+    // Core profiles need a vertex array bound to draw, even one without attributes
+    unsigned int emptyVAO_;
+    // Active uniforms by name, arrays are also found by their name without "[0]"
+    std::map<std::string, GLint, std::less<>> uniformLocations_;
     void initRenderData();
 
+    Shader() = default;
     void checkCompileErrors(unsigned int object, std::string type);
-    
+    // Reports compile and link errors, releases the shader objects and caches the uniform locations
+    void finishLink();
+    void cacheUniformLocations();
   };
 }
 
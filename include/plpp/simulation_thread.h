@@ -0,0 +1,124 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/fixed_timestep.h"
+#include "plpp/physics_engine.h"
+#include "plpp/rate_counter.h"
+#include "plpp/spawn_distribution.h"
+#include "plpp/trajectory_recorder.h"
+#include "plpp/triple_buffer.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace PLPP
+{
+  // A finished step as handed to the renderer
+  struct SimulationFrame
+  {
+    std::vector<glm::vec2> positions;
+    // Positions before the step, the renderer interpolates between the two
+    std::vector<glm::vec2> previousPositions;
+    std::vector<int> types;
+    uint64_t step = 0;
+    float stepSeconds = 0.0f;
+    // Latest observables of the engine, empty unless collectObservables is set
+    StepObservables observables;
+    std::chrono::steady_clock::time_point publishedAt;
+
+    // Fraction of the next step elapsed at now, for interpolating the draw
+    float GetAlpha(std::chrono::steady_clock::time_point now) const
+    {
+      if (stepSeconds <= 0.0f)
+        return 1.0f;
+      float elapsed = std::chrono::duration<float>(now - publishedAt).count();
+      return std::clamp(elapsed / stepSeconds, 0.0f, 1.0f);
+    }
+  };
+
+  // Steps the CPU backend on its own thread at a fixed rate, independent of the frame rate.
+  // Every step is published through a triple buffer, so the renderer never waits for the
+  // simulation and always draws the latest complete state. Everything the render thread wants
+  // changed is queued and applied between two steps.
+  class SimulationThread
+  {
+  public:
+    // threadCount is passed to the CPU backend's pool
+    explicit SimulationThread(int threadCount = 0);
+    ~SimulationThread() { Stop(); }
+
+    // Takes over the parameters and particles of source and starts stepping
+    void Start(PhysicsEngine &source);
+    // Joins the thread, the final state stays readable through GetEngine
+    void Stop();
+    bool IsRunning() const { return thread_.joinable(); }
+    // Only safe to use while the thread is stopped
+    CPUPhysicsEngine &GetEngine() { return *engine_; }
+
+    // Applied before the next step
+    void SetParameters(PhysicsEngine &source);
+    void SetTimestep(const FixedTimestep &timestep);
+    void SetDisplay(glm::ivec2 display);
+    void SetPaused(bool paused);
+    void AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions);
+    void SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display);
+    // Written by the simulation thread between two steps
+    void SaveSnapshot(const std::filesystem::path &path, glm::ivec2 display);
+    // Every interval-th step is submitted to recorder, nullptr stops. Once it returns the thread
+    // no longer touches the previous recorder.
+    void SetRecorder(TrajectoryRecorder *recorder, int interval = 1);
+
+    // Render thread side, takes the latest published frame and returns whether it is new
+    bool AcquireFrame() { return frames_.Acquire(); }
+    const SimulationFrame &GetFrame() const { return frames_.GetReadBuffer(); }
+    double GetStepRate() const { return stepRate_.GetRate(); }
+
+  private:
+    int threadCount_;
+    std::unique_ptr<CPUPhysicsEngine> engine_;
+    std::thread thread_;
+    std::atomic<bool> stopping_ = false;
+    TripleBuffer<SimulationFrame> frames_;
+    RateCounter stepRate_;
+    uint64_t step_ = 0;
+    // Positions of the last published frame, the previous positions of the next one
+    std::vector<glm::vec2> lastPositions_, velocities_;
+
+    // Pending changes, guarded by commandMutex_
+    std::mutex commandMutex_;
+    // Parameter store only, never stepped
+    CPUPhysicsEngine parameters_;
+    bool parametersChanged_ = false;
+    FixedTimestep timestep_;
+    glm::ivec2 display_;
+    bool paused_ = true;
+    std::vector<std::function<void(CPUPhysicsEngine &)>> commands_;
+    // Held while a step is submitted, so the recorder can be swapped without queueing
+    std::mutex recorderMutex_;
+    TrajectoryRecorder *recorder_ = nullptr;
+    int recordInterval_ = 1;
+
+    void run();
+    void publish(float stepSeconds, glm::ivec2 display);
+
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+  };
+}
+
+#endif
@@ -2,14 +2,25 @@
 #define SIMULATOR_H
 
 // Project Includes
-#include "plpp/physics_engine.h"
+#include "plpp/gpu_physics_engine.h"
 #include "plpp/overlay.h"
 #include "plpp/clock.h"
+#include "plpp/fixed_timestep.h"
+#include "plpp/metrics_writer.h"
+#include "plpp/rate_counter.h"
+#include "plpp/simulation_thread.h"
+#include "plpp/trajectory_capture.h"
+#include "plpp/trajectory_player.h"
+#include "plpp/trajectory_recorder.h"
 
 // External Libraries
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
 
+// C++ Standard Library
+#include <filesystem>
+#include <span>
+
 namespace PLPP
 {
   class Simulator
@@ -35,10 +46,19 @@ namespace PLPP
     ~Simulator() { glfwTerminate(); };
 
     void ProcessInput();
-    void Update(float delta);
+    void Update(double frameSeconds);
     void Render();
 
     GLFWwindow *Init();
+    // Hands the particles over between the GPU backend and the simulation thread
+    void setSimulationThreadEnabled(bool enabled);
+    // Draws with the primitive the overlay asks for, or the cheapest one for the on-screen radius
+    void renderParticles(unsigned int positions, unsigned int previousPositions, unsigned int types, float alpha, int particleCount);
+    void uploadFrame(std::span<const glm::vec2> positions, std::span<const glm::vec2> previousPositions, std::span<const int> types);
+    void saveSnapshot(const std::filesystem::path &path);
+    void loadSnapshot(const std::filesystem::path &path);
+    void setRecordingEnabled(bool enabled);
+    void setReplayEnabled(bool enabled);
 
     Simulator(const Simulator &) = delete;
     Simulator &operator=(const Simulator &) = delete;
@@ -47,9 +67,25 @@ namespace PLPP
 
     SimulatorState state_;
     GLFWwindow *window_;
-    PhysicsEngine physicsEngine_;
+    GPUPhysicsEngine physicsEngine_;
+    // While running it owns the particles, physicsEngine_ only holds the parameters the overlay edits
+    SimulationThread simulationThread_;
+    // Positions, previous positions and types of the latest frame of the simulation thread or replay
+    GLuint frameBuffers_[3];
+    FixedTimestep timestep_;
+    RateCounter frameRate_;
+    RateCounter stepRate_;
+    MetricsWriter metrics_;
+    // The GPU backend's frames are staged by capture_, the simulation thread submits its own
+    TrajectoryRecorder recorder_;
+    TrajectoryCapture capture_;
+    // While it is open the simulation is held and the recorded frames are drawn instead
+    TrajectoryPlayer player_;
     Overlay overlay_;
-    Shader particleShader_;
+    // One variant per ParticlePrimitive, each is timed under its own name by the GPU profiler
+    Shader particleShaders_[3];
+    // Largest point radius the driver rasterizes
+    float maximumPointRadius_;
     Clock clock_;
   };
 }
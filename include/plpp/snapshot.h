@@ -0,0 +1,77 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Project Includes
+#include "plpp/physics_engine.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <filesystem>
+
+namespace PLPP
+{
+  // Simulation parameters of a snapshot, fixed width so the layout is the same on every compiler
+  struct SnapshotParameters
+  {
+    float friction;
+    float particleRadius;
+    float forceMultiplier;
+    float effectiveForceRadius;
+    float forceLawInnerRadius;
+    int32_t boundaryMode;
+    int32_t forceLaw;
+    int32_t useSpatialGrid;
+    int32_t autoSelectKernel;
+    int32_t reserved[3];
+  };
+  static_assert(sizeof(SnapshotParameters) == 48, "SnapshotParameters must keep its layout");
+
+  // Start of a snapshot file. The sections follow at the recorded offsets, each aligned to
+  // SNAPSHOT_ALIGNMENT: the force matrix (maximumTypes^2 floats), the palette (maximumTypes vec4),
+  // then the particles as one array per attribute (vec2 positions, vec2 velocities, int types),
+  // laid out like the GPU backend's buffers. Values are stored in the host's byte order.
+  struct SnapshotHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t maximumTypes;
+    // Highest type id in use plus one
+    int32_t typeCount;
+    uint64_t particleCount;
+    int32_t displayWidth;
+    int32_t displayHeight;
+    SnapshotParameters parameters;
+    uint64_t forcesOffset;
+    uint64_t colorsOffset;
+    uint64_t positionsOffset;
+    uint64_t velocitiesOffset;
+    uint64_t typesOffset;
+    uint64_t fileSize;
+  };
+  static_assert(sizeof(SnapshotHeader) == 136, "SnapshotHeader must keep its layout");
+
+  // Saves and restores a whole world: parameters, force matrix, palette and particles. Loading
+  // maps the file and hands the particle arrays to the backend as they are, without parsing. The
+  // GPU backend copies each array into its mapped buffers in one go, the CPU backend splits the
+  // coordinates into its own arrays.
+  class Snapshot
+  {
+  public:
+    static constexpr char MAGIC[8] = {'P', 'L', 'P', 'P', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t VERSION = 1;
+
+    // Reads the particles back from the backend, which waits for its pending steps
+    static bool Save(const std::filesystem::path &path, PhysicsEngine &engine, glm::ivec2 display);
+    // Replaces the particles and parameters of engine, display receives the size the world was saved at
+    static bool Load(const std::filesystem::path &path, PhysicsEngine &engine, glm::ivec2 *display = nullptr);
+
+  private:
+    Snapshot() {}
+  };
+}
+
+#endif
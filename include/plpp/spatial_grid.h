@@ -0,0 +1,53 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+// Project Includes
+#include "plpp/constants.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+
+namespace PLPP
+{
+  // Layout of the uniform grid particles are binned into, shared by the GPU and CPU backends
+  struct SpatialGrid
+  {
+    glm::vec2 origin;
+    float cellSize;
+    glm::ivec2 dimensions;
+
+    int GetCellCount() const { return dimensions.x * dimensions.y; }
+
+    glm::ivec2 GetCell(glm::vec2 position) const
+    {
+      return glm::ivec2(std::clamp(static_cast<int>(std::floor((position.x - origin.x) / cellSize)), 0, dimensions.x - 1),
+                        std::clamp(static_cast<int>(std::floor((position.y - origin.y) / cellSize)), 0, dimensions.y - 1));
+    }
+
+    // Covers the same area as the wrap boundaries. Cells must be at least as wide as the force
+    // radius for the 3x3 neighbourhood to be exhaustive, and widen further to stay within
+    // GRID_MAXIMUM_CELLS.
+    static SpatialGrid Fit(glm::ivec2 display, float particleRadius, float forceRadius)
+    {
+      SpatialGrid grid;
+      grid.origin = glm::vec2(-particleRadius, -particleRadius);
+      glm::vec2 extent(display.x + 2.0f * particleRadius, display.y + 2.0f * particleRadius);
+
+      grid.cellSize = std::max(forceRadius, std::sqrt(extent.x * extent.y / GRID_MAXIMUM_CELLS));
+      while (true)
+      {
+        grid.dimensions = glm::ivec2(std::max(1, static_cast<int>(std::ceil(extent.x / grid.cellSize))),
+                                     std::max(1, static_cast<int>(std::ceil(extent.y / grid.cellSize))));
+        if (grid.GetCellCount() <= GRID_MAXIMUM_CELLS)
+          return grid;
+        grid.cellSize *= 1.01f;
+      }
+    }
+  };
+}
+
+#endif
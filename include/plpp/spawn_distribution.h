@@ -0,0 +1,49 @@
+#ifndef SPAWN_DISTRIBUTION_H
+#define SPAWN_DISTRIBUTION_H
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <vector>
+
+namespace PLPP
+{
+  enum class SpawnLayout
+  {
+    // Spread evenly over the display
+    Uniform,
+    // Scattered in discs around clusterCount random centres
+    Clustered
+  };
+
+  // Describes a batch of particles to create. Every particle is sampled from a counter-based
+  // RNG keyed on (seed, index), so particles can be generated independently and in any order.
+  // seed.comp implements the same sampling, both backends produce the same world for a seed.
+  struct SpawnDistribution
+  {
+    int count = 0;
+    SpawnLayout layout = SpawnLayout::Uniform;
+    // Relative share of each type, type i is drawn with probability typeWeights[i] / sum
+    std::vector<float> typeWeights = {1.0f};
+    int clusterCount = 8;
+    float clusterRadius = 60.0f;
+    uint32_t seed = 0;
+
+    // Cumulative normalized weights, type i covers [thresholds[i - 1], thresholds[i])
+    std::vector<float> GetTypeThresholds() const;
+    int SampleType(uint32_t index, const std::vector<float> &typeThresholds) const;
+    glm::vec2 SamplePosition(uint32_t index, glm::vec2 display) const;
+
+    // A distribution putting all particles on a single type
+    static SpawnDistribution SingleType(int typeId, int count, uint32_t seed);
+
+    // PCG hash of (seed, index, stream), streams keep the draws of one particle independent
+    static uint32_t Random(uint32_t seed, uint32_t index, uint32_t stream);
+    // Uniform float in [0, 1) with 24 random bits, exactly representable on both sides
+    static float RandomFloat(uint32_t seed, uint32_t index, uint32_t stream);
+  };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef STRIP_DECOMPOSITION_H
+#define STRIP_DECOMPOSITION_H
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+
+namespace PLPP
+{
+  // Splits the world into vertical strips of equal width, one per worker. The strips cover the
+  // same extent as the wrap boundaries, so a particle leaving the last strip to the right
+  // re-enters the first one and the workers form a ring.
+  struct StripDecomposition
+  {
+    int workerCount;
+    float origin;
+    float stripWidth;
+
+    float GetBegin(int rank) const { return origin + rank * stripWidth; }
+    float GetEnd(int rank) const { return origin + (rank + 1) * stripWidth; }
+
+    int GetOwner(float x) const
+    {
+      return std::clamp(static_cast<int>(std::floor((x - origin) / stripWidth)), 0, workerCount - 1);
+    }
+
+    int GetLeft(int rank) const { return (rank + workerCount - 1) % workerCount; }
+    int GetRight(int rank) const { return (rank + 1) % workerCount; }
+
+    static StripDecomposition Fit(glm::ivec2 display, float particleRadius, int workerCount)
+    {
+      StripDecomposition decomposition;
+      decomposition.workerCount = std::max(1, workerCount);
+      decomposition.origin = -particleRadius;
+      decomposition.stripWidth = (display.x + 2.0f * particleRadius) / decomposition.workerCount;
+      return decomposition;
+    }
+
+    // Halos only reach the direct neighbours, which requires strips at least as wide as the
+    // force radius
+    static int GetMaximumWorkers(glm::ivec2 display, float particleRadius, float forceRadius)
+    {
+      return std::max(1, static_cast<int>((display.x + 2.0f * particleRadius) / forceRadius));
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SUBDOMAIN_WORKER_H
+#define SUBDOMAIN_WORKER_H
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/halo_exchange.h"
+#include "plpp/scenario.h"
+#include "plpp/strip_decomposition.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstdint>
+#include <vector>
+
+namespace PLPP
+{
+  // Steps the particles of one strip of the world inside a worker process. Before every step the
+  // workers swap the particles that left their strip and the halo particles within the force
+  // radius of their borders with their neighbours, so the strip is stepped exactly as the
+  // single-process run would step it.
+  //
+  // The force kernels use direct distances, particles only wrap by position. Halos therefore
+  // stop at the display edges while migration follows the ring across them.
+  class SubdomainWorker
+  {
+  public:
+    // Spawns the scenario's world and keeps the particles inside the rank's strip
+    SubdomainWorker(HaloExchange &exchange, int rank, Scenario scenario, uint64_t seed, int threadCount);
+
+    // Exchanges with the neighbours and advances the strip, false once the run was aborted
+    bool Step(float deltaTime);
+    // Hands the owned particles to the launcher and fills the rank's report
+    void Finish(double stepSeconds);
+
+    const CPUPhysicsEngine &GetEngine() const { return engine_; }
+
+  private:
+    HaloExchange &exchange_;
+    int rank_;
+    glm::ivec2 display_;
+    StripDecomposition decomposition_;
+    CPUPhysicsEngine engine_;
+    // Global id of every engine slot
+    std::vector<int> ids_;
+    int parity_ = 0;
+
+    double exchangeSeconds_ = 0.0;
+    uint64_t migrants_ = 0;
+    uint64_t haloParticles_ = 0;
+
+    std::vector<glm::vec2> positions_, velocities_;
+    std::vector<int> types_;
+    std::vector<int> emigrantSlots_, haloTypes_;
+    std::vector<glm::vec2> haloPositions_;
+    std::vector<ParticleRecord> immigrants_;
+
+    void removeSlots(const std::vector<int> &slots);
+    void receive(HaloExchange::Mailbox mailbox);
+  };
+}
+
+#endif
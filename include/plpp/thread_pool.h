@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// C++ Standard Library
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace PLPP
+{
+  // Persistent pool of workers with one chunk queue each. Workers drain their own queue from
+  // the back and steal from the front of the others' once it runs dry. The calling thread
+  // takes part as worker 0, so a pool of one thread runs everything inline.
+  class ThreadPool
+  {
+  public:
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    // Splits [0, count) into chunks of grainSize and runs task(begin, end) on every chunk,
+    // returning once all of them have finished
+    void ParallelFor(int count, int grainSize, const std::function<void(int, int)> &task);
+
+    int GetThreadCount() const { return static_cast<int>(queues_.size()); }
+    uint64_t GetStealCount() const { return steals_.load(std::memory_order_relaxed); }
+
+  private:
+    struct WorkerQueue
+    {
+      std::mutex mutex;
+      std::deque<std::pair<int, int>> chunks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable doneCondition_;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+
+    const std::function<void(int, int)> *task_ = nullptr;
+    std::atomic<int> remainingChunks_ = 0;
+    std::atomic<uint64_t> steals_ = 0;
+
+    void workerLoop(int index);
+    bool runChunk(int index);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+  };
+}
+
+#endif
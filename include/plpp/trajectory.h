@@ -0,0 +1,154 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+// Project Includes
+#include "plpp/constants.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace PLPP
+{
+  // Start of a trajectory file, the frames follow back to back. Close appends the frame index and
+  // fills in indexOffset and frameCount, a file that was never closed has them at zero and its
+  // frames are found by walking the frame headers. Values are stored in the host's byte order.
+  struct TrajectoryFileHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t keyframeInterval;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t frameCount;
+  };
+  static_assert(sizeof(TrajectoryFileHeader) == 40, "TrajectoryFileHeader must keep its layout");
+
+  enum TrajectoryFrameFlags : uint32_t
+  {
+    // Decodes on its own, every other frame needs the frames since the last keyframe
+    TRAJECTORY_KEYFRAME = 1u
+  };
+
+  // Precedes the payload of every frame. Positions are stored as 16 bit fractions of a period
+  // starting at origin, so a particle wrapping around the world is a small step modulo 2^16.
+  // Velocities are 16 bit multiples of velocityScale. A keyframe stores the types as bytes and
+  // the quantized values as they are. A delta frame stores the change of each quantized velocity
+  // and the miss of each predicted position, zigzag coded and bit packed in blocks of 32 at the
+  // width of the largest, one stream per component (velocity x, y, position x, y). The prediction
+  // moves the previous position by predictionScale * ((n - 1) * previous + (n + 1) * current)
+  // quantized velocity, the trapezoid over the n steps since the previous frame.
+  struct TrajectoryFrameHeader
+  {
+    uint32_t tag;
+    uint32_t flags;
+    uint64_t step;
+    uint32_t particleCount;
+    uint32_t payloadSize;
+    int32_t displayWidth;
+    int32_t displayHeight;
+    float originX;
+    float originY;
+    float periodX;
+    float periodY;
+    float velocityScale;
+    float stepSeconds;
+    float predictionScaleX;
+    float predictionScaleY;
+  };
+  static_assert(sizeof(TrajectoryFrameHeader) == 64, "TrajectoryFrameHeader must keep its layout");
+
+  // One entry of the index written by Close, and what readers build when there is none
+  struct TrajectoryIndexEntry
+  {
+    uint64_t offset;
+    uint64_t step;
+    uint32_t flags;
+    uint32_t particleCount;
+  };
+  static_assert(sizeof(TrajectoryIndexEntry) == 24, "TrajectoryIndexEntry must keep its layout");
+
+  // Particle state handed to the encoder, the spans have to stay valid until it returns
+  struct TrajectoryFrameView
+  {
+    uint64_t step = 0;
+    glm::ivec2 display{0, 0};
+    float particleRadius = 0.0f;
+    float stepSeconds = 0.0f;
+    std::span<const glm::vec2> positions;
+    std::span<const glm::vec2> velocities;
+    std::span<const int> types;
+  };
+
+  // A decoded frame
+  struct TrajectoryFrame
+  {
+    uint64_t step = 0;
+    glm::ivec2 display{0, 0};
+    float stepSeconds = 0.0f;
+    std::vector<glm::vec2> positions;
+    std::vector<glm::vec2> velocities;
+    std::vector<int> types;
+  };
+
+  // Quantized particles of the last frame, what a delta frame is coded against
+  struct TrajectoryState
+  {
+    bool valid = false;
+    TrajectoryFrameHeader header{};
+    std::vector<uint16_t> positions;
+    std::vector<int16_t> velocities;
+    std::vector<uint8_t> types;
+  };
+
+  class TrajectoryEncoder
+  {
+  public:
+    static constexpr uint32_t FRAME_TAG = 0x4D415246u;
+
+    int keyframeInterval = TRAJECTORY_KEYFRAME_INTERVAL;
+
+    // Appends the frame header and payload to out. A delta frame is written when the frame has
+    // the particles of the last one and their values fit its quantization, a keyframe otherwise.
+    void Encode(const TrajectoryFrameView &frame, std::vector<uint8_t> &out);
+    // The next frame is written as a keyframe
+    void Reset() { state_.valid = false; }
+
+  private:
+    TrajectoryState state_;
+    int framesSinceKeyframe_ = 0;
+    // Quantized values of the delta frame being coded, swapped into the state once it is complete
+    std::vector<uint16_t> positions_;
+    std::vector<int16_t> velocities_;
+    std::vector<uint32_t> residuals_;
+
+    void encodeKeyframe(const TrajectoryFrameView &frame, std::vector<uint8_t> &out);
+    // Writes nothing and returns false if a value does not fit the last keyframe's quantization
+    bool encodeDelta(const TrajectoryFrameView &frame, std::vector<uint8_t> &out);
+  };
+
+  class TrajectoryDecoder
+  {
+  public:
+    // Applies a frame to the state, a delta frame needs the frame before it to have been applied.
+    // False if the payload is corrupt or the delta does not follow the state.
+    bool Apply(const TrajectoryFrameHeader &header, std::span<const uint8_t> payload);
+    bool HasState() const { return state_.valid; }
+    uint64_t GetStep() const { return state_.header.step; }
+    // Dequantizes the state into frame
+    void Read(TrajectoryFrame &frame) const;
+    void Reset() { state_.valid = false; }
+
+  private:
+    TrajectoryState state_;
+    std::vector<uint32_t> residuals_;
+  };
+}
+
+#endif
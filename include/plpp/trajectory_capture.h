@@ -0,0 +1,66 @@
+#ifndef TRAJECTORY_CAPTURE_H
+#define TRAJECTORY_CAPTURE_H
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/gpu_physics_engine.h"
+#include "plpp/trajectory_recorder.h"
+
+// External Libraries
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <atomic>
+#include <cstdint>
+
+namespace PLPP
+{
+  // Records the GPU backend without waiting for it. A capture copies the particle buffers into a
+  // persistently mapped staging buffer on the GPU and fences the copy, a later Poll hands the
+  // staged frames whose fence signalled to the recorder's writer, which reads them in place.
+  // Captures finding every staging buffer busy are dropped. Only used on the GL context's thread.
+  class TrajectoryCapture
+  {
+  public:
+    TrajectoryCapture() = default;
+    ~TrajectoryCapture();
+
+    // Queues the copy of the engine's current state, taken after its last issued step
+    void Capture(GPUPhysicsEngine &engine, TrajectoryRecorder &recorder, glm::ivec2 display, float stepSeconds);
+    // Submits the finished copies and recycles the buffers the writer is done with
+    void Poll(TrajectoryRecorder &recorder);
+    // Waits for the copies still in flight and submits them, call before closing the recorder
+    void Flush(TrajectoryRecorder &recorder);
+
+  private:
+    enum class SlotState
+    {
+      Free,
+      // The GPU copy is in flight
+      Copying,
+      // Handed to the writer, free once it released it
+      Writing
+    };
+    // Positions, velocities and types of up to capacity particles, one array after the other
+    struct StagingSlot
+    {
+      GLuint buffer = 0;
+      unsigned char *pointer = nullptr;
+      int capacity = 0;
+      GLsync fence = nullptr;
+      SlotState state = SlotState::Free;
+      std::atomic<bool> released = false;
+      TrajectoryFrameView frame;
+    };
+    StagingSlot slots_[TRAJECTORY_STAGING_FRAMES];
+
+    // Makes the slot large enough for capacity particles, its contents are lost
+    void reserve(StagingSlot &slot, int capacity);
+
+    TrajectoryCapture(const TrajectoryCapture &) = delete;
+    TrajectoryCapture &operator=(const TrajectoryCapture &) = delete;
+  };
+}
+
+#endif
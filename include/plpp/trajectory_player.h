@@ -0,0 +1,88 @@
+#ifndef TRAJECTORY_PLAYER_H
+#define TRAJECTORY_PLAYER_H
+
+// Project Includes
+#include "plpp/trajectory.h"
+#include "plpp/trajectory_reader.h"
+#include "plpp/triple_buffer.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PLPP
+{
+  // The two recorded frames around the playhead, the renderer blends from previous to current
+  struct ReplayFrame
+  {
+    TrajectoryFrame current;
+    // Positions of the frame before current, current's own for the first frame
+    std::vector<glm::vec2> previousPositions;
+    uint64_t previousStep = 0;
+  };
+
+  // Plays back a trajectory file. The playhead moves in simulation steps on the caller's thread, a
+  // loader thread decodes the frames around it and publishes them through a triple buffer, so the
+  // renderer never waits for a decode or a page fault. While idle the loader reads ahead of the
+  // playhead and hands the pages behind it back to the OS, so recordings larger than memory play
+  // back as well.
+  class TrajectoryPlayer
+  {
+  public:
+    // Recorded steps played per second of wall time, relative to the recorded step rate
+    float speed = 1.0f;
+    bool paused = false;
+
+    ~TrajectoryPlayer() { Close(); }
+
+    bool Open(const std::filesystem::path &path);
+    void Close();
+    bool IsOpen() const { return loader_.joinable(); }
+
+    // Moves the playhead by frameSeconds, stops at the last frame
+    void Update(double frameSeconds);
+    // Puts the playhead on step, clamped to the recording
+    void Seek(double step);
+    double GetPlayhead() const { return playhead_; }
+    uint64_t GetFirstStep() const { return reader_.GetEntry(0).step; }
+    uint64_t GetLastStep() const { return reader_.GetEntry(reader_.GetFrameCount() - 1).step; }
+    size_t GetFrameCount() const { return reader_.GetFrameCount(); }
+
+    // Takes the latest decoded frames and returns whether they are new
+    bool AcquireFrame() { return frames_.Acquire(); }
+    const ReplayFrame &GetFrame() const { return frames_.GetReadBuffer(); }
+    // Share of the way from the previous to the current frame the playhead is at
+    float GetAlpha() const;
+
+  private:
+    // The index is only read once Open returned, decoding and paging belong to the loader
+    TrajectoryReader reader_;
+    double playhead_ = 0.0;
+    std::thread loader_;
+    TripleBuffer<ReplayFrame> frames_;
+
+    // Frame the loader should publish as current, guarded by mutex_ together with stopping_
+    std::mutex mutex_;
+    std::condition_variable targetChanged_;
+    size_t target_ = 0;
+    bool stopping_ = false;
+
+    // Loader side, the range of the file it has faulted in
+    uint64_t residentBegin_ = 0, residentEnd_ = 0;
+
+    void setTarget(size_t frame);
+    void run();
+    // Faults in the bytes following frame in steps, false if the target changed in between
+    bool readAhead(size_t frame);
+  };
+}
+
+#endif
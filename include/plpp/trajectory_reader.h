@@ -0,0 +1,49 @@
+#ifndef TRAJECTORY_READER_H
+#define TRAJECTORY_READER_H
+
+// Project Includes
+#include "plpp/mapped_file.h"
+#include "plpp/trajectory.h"
+
+// C++ Standard Library
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace PLPP
+{
+  // Reads frames of a trajectory file written by TrajectoryRecorder through a memory mapping.
+  // Reading the frames in order decodes each once, any other frame is decoded from the keyframe
+  // before it.
+  class TrajectoryReader
+  {
+  public:
+    // Takes the frame index from the file, or walks the frames of a recording that was never
+    // closed up to the first incomplete one
+    bool Open(const std::filesystem::path &path);
+    void Close();
+    bool IsOpen() const { return file_.IsOpen(); }
+
+    size_t GetFrameCount() const { return index_.size(); }
+    const TrajectoryIndexEntry &GetEntry(size_t frame) const { return index_[frame]; }
+    // Latest frame at or before step, 0 if step precedes the recording
+    size_t FindFrame(uint64_t step) const;
+    // Latest keyframe at or before frame
+    size_t FindKeyframe(size_t frame) const;
+    const MappedFile &GetFile() const { return file_; }
+
+    bool ReadFrame(size_t frame, TrajectoryFrame &out);
+
+  private:
+    MappedFile file_;
+    std::vector<TrajectoryIndexEntry> index_;
+    TrajectoryDecoder decoder_;
+    // Frame the decoder holds, or -1
+    int64_t decodedFrame_ = -1;
+
+    bool isFrame(uint64_t offset, TrajectoryFrameHeader &header) const;
+  };
+}
+
+#endif
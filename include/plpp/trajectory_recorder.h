@@ -0,0 +1,106 @@
+#ifndef TRAJECTORY_RECORDER_H
+#define TRAJECTORY_RECORDER_H
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/trajectory.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PLPP
+{
+  // Counters of a recording, readable from any thread
+  struct TrajectoryStatistics
+  {
+    uint64_t framesWritten = 0;
+    // Frames given up because the writer had TRAJECTORY_STAGING_FRAMES waiting already
+    uint64_t framesDropped = 0;
+    uint64_t keyframesWritten = 0;
+    uint64_t bytesWritten = 0;
+    // What the written frames take as float positions and velocities
+    uint64_t rawBytes = 0;
+
+    double GetCompressionRatio() const { return bytesWritten ? static_cast<double>(rawBytes) / bytesWritten : 0.0; }
+  };
+
+  // Writes a trajectory file on a thread of its own. Submitting a frame only queues it, the writer
+  // encodes and writes it behind the caller's back. At most TRAJECTORY_STAGING_FRAMES wait at a
+  // time, when the disk can't keep up frames are dropped and counted rather than stalling the
+  // simulation.
+  class TrajectoryRecorder
+  {
+  public:
+    static constexpr char MAGIC[8] = {'P', 'L', 'P', 'P', 'T', 'R', 'A', 'J'};
+    static constexpr uint32_t VERSION = 1;
+
+    // Makes Submit wait for room instead of dropping, for offline runs that need every frame
+    bool dropWhenBusy = true;
+
+    ~TrajectoryRecorder() { Close(); }
+
+    // Truncates the file, writes its header and starts the writer, false if it can't be opened
+    bool Open(const std::filesystem::path &path, int keyframeInterval = TRAJECTORY_KEYFRAME_INTERVAL);
+    // Writes the frames still queued and the frame index, then stops the writer
+    void Close();
+    bool IsOpen() const { return writer_.joinable(); }
+
+    // Copies the frame for the writer, false if it was dropped
+    bool Submit(const TrajectoryFrameView &frame);
+    // Queues a frame the writer reads in place, released is set once it no longer touches the
+    // spans. False if the frame was dropped, released is left alone then.
+    bool SubmitBorrowed(const TrajectoryFrameView &frame, std::atomic<bool> &released);
+    // For producers that lose a frame before it gets here
+    void CountDrop() { framesDropped_.fetch_add(1, std::memory_order_relaxed); }
+    TrajectoryStatistics GetStatistics() const;
+
+  private:
+    struct Job
+    {
+      TrajectoryFrameView frame;
+      // Index into copies_, or -1 for a borrowed frame
+      int copy = -1;
+      std::atomic<bool> *released = nullptr;
+    };
+    struct FrameCopy
+    {
+      std::vector<glm::vec2> positions, velocities;
+      std::vector<int> types;
+      bool inUse = false;
+    };
+
+    std::ofstream file_;
+    std::thread writer_;
+    TrajectoryEncoder encoder_;
+    std::vector<TrajectoryIndexEntry> index_;
+    uint64_t offset_ = 0;
+
+    // Guards the queue, the copies' inUse flags, inFlight_ and stopping_
+    std::mutex mutex_;
+    std::condition_variable queued_, finished_;
+    std::deque<Job> jobs_;
+    FrameCopy copies_[TRAJECTORY_STAGING_FRAMES];
+    // Frames queued or being written
+    int inFlight_ = 0;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> framesWritten_ = 0, framesDropped_ = 0, keyframesWritten_ = 0, bytesWritten_ = 0, rawBytes_ = 0;
+
+    // Waits for room in the queue unless frames are dropped, false if there is none
+    bool reserve(std::unique_lock<std::mutex> &lock);
+    void run();
+  };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+// C++ Standard Library
+#include <atomic>
+#include <cstdint>
+
+namespace PLPP
+{
+  // Lock-free handoff of the latest state from one writer thread to one reader thread. The writer
+  // fills its buffer and publishes it by swapping it with the shared middle buffer, the reader
+  // swaps its buffer with the middle one whenever a newer state was published. Neither side ever
+  // waits, the reader always sees the latest complete state and the writer overwrites states the
+  // reader skipped.
+  template <typename T>
+  class TripleBuffer
+  {
+  public:
+    // Writer side, the buffer belongs to the writer until Publish
+    T &GetWriteBuffer() { return buffers_[writeIndex_]; }
+    void Publish()
+    {
+      uint8_t middle = latest_.exchange(static_cast<uint8_t>(writeIndex_ | FreshBit), std::memory_order_acq_rel);
+      writeIndex_ = middle & IndexMask;
+    }
+
+    // Reader side, takes the latest published state if there is one, returns whether it did
+    bool Acquire()
+    {
+      if (!(latest_.load(std::memory_order_relaxed) & FreshBit))
+        return false;
+      uint8_t middle = latest_.exchange(readIndex_, std::memory_order_acq_rel);
+      readIndex_ = middle & IndexMask;
+      return true;
+    }
+    // Stays the same until the next successful Acquire
+    const T &GetReadBuffer() const { return buffers_[readIndex_]; }
+
+  private:
+    static constexpr uint8_t IndexMask = 0x3;
+    // Set while the middle buffer holds a state the reader has not taken yet
+    static constexpr uint8_t FreshBit = 0x4;
+
+    T buffers_[3];
+    std::atomic<uint8_t> latest_ = 1;
+    uint8_t writeIndex_ = 0;
+    uint8_t readIndex_ = 2;
+  };
+}
+
+#endif
@@ -1,18 +1,24 @@
 #version 440 core
 
-in vec2 fragCenter;
-in vec4 fragColor;
+#ifndef PARTICLE_PRIMITIVE
+#define PARTICLE_PRIMITIVE 0
+#endif
 
-out vec4 outColor;
+#if PARTICLE_PRIMITIVE == 0
+in vec2 fragOffset;
+#endif
+flat in vec4 fragColor;
 
-uniform float radius;
-uniform vec2 u_resolution;
+out vec4 outColor;
 
 void main()
 {
-    // Invert y
-    vec2 center_inverted = vec2(fragCenter.x, u_resolution.y - fragCenter.y);
-    vec2 dist = gl_FragCoord.xy - center_inverted;
-    if (length(dist) > radius) discard;
+    // The offset from the centre comes interpolated in radii, no flip or square root needed
+#if PARTICLE_PRIMITIVE == 0
+    if (dot(fragOffset, fragOffset) > 1.0) discard;
+#elif PARTICLE_PRIMITIVE == 1
+    vec2 offset = gl_PointCoord * 2.0 - 1.0;
+    if (dot(offset, offset) > 1.0) discard;
+#endif
     outColor = vec4(fragColor.rgb, 1);
 }
\ No newline at end of file
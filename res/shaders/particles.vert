@@ -1,22 +1,62 @@
 #version 440 core
 
+// How the particles are rasterized, set by the variant: 0 = a quad of two triangles,
+// 1 = a point of the particle's diameter, 2 = a single pixel
+#ifndef PARTICLE_PRIMITIVE
+#define PARTICLE_PRIMITIVE 0
+#endif
+
 layout (std430, binding = 0) buffer Positions {
     vec2 positions[];
 };
-layout (location = 0) in vec2 aPos;
-
-layout (location = 1) in vec4 aColor;
+// State before the last step, positions are drawn blended between the two
+layout (std430, binding = 1) buffer PreviousPositions {
+    vec2 previousPositions[];
+};
+layout (std430, binding = 3) buffer TypeIds {
+    int typeIds[];
+};
+// One colour per particle type
+layout (std430, binding = 10) buffer Palette {
+    vec4 palette[];
+};
 
 uniform mat4 projection;
 uniform float radius;
+uniform vec2 u_resolution;
+// Fraction of a simulation step elapsed since positions were written
+uniform float alpha;
 
-out vec2 fragCenter;
-out vec4 fragColor;
+#if PARTICLE_PRIMITIVE == 0
+// Corners of the two triangles, the vertices are pulled by gl_VertexID without any attributes
+const vec2 corners[6] = vec2[6](vec2(-1.0, 1.0), vec2(1.0, -1.0), vec2(-1.0, -1.0),
+                                vec2(-1.0, 1.0), vec2(1.0, -1.0), vec2(1.0, 1.0));
+// Position within the quad, the disc is where it is inside the unit circle
+out vec2 fragOffset;
+#endif
+flat out vec4 fragColor;
 
 void main()
 {
-    vec2 worldPos = positions[gl_InstanceID] + aPos * radius;
-    gl_Position = (projection * vec4(worldPos, 0.0, 1.0));
-    fragCenter = positions[gl_InstanceID];
-    fragColor = aColor;
+#if PARTICLE_PRIMITIVE == 0
+    int particle = gl_VertexID / 6;
+    vec2 corner = corners[gl_VertexID % 6];
+#else
+    int particle = gl_VertexID;
+#endif
+
+    vec2 current = positions[particle];
+    vec2 previous = previousPositions[particle];
+    // A particle that wrapped around the display is drawn where it landed instead of sweeping across
+    bool wrapped = any(greaterThan(abs(current - previous), u_resolution * 0.5));
+    vec2 center = wrapped ? current : mix(previous, current, alpha);
+
+#if PARTICLE_PRIMITIVE == 0
+    gl_Position = projection * vec4(center + corner * radius, 0.0, 1.0);
+    fragOffset = corner;
+#else
+    gl_Position = projection * vec4(center, 0.0, 1.0);
+    gl_PointSize = PARTICLE_PRIMITIVE == 1 ? 2.0 * radius : 1.0;
+#endif
+    fragColor = palette[typeIds[particle]];
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+// Shared by the force kernels particles.comp, particles_tiled.comp and particles_brute.comp,
+// ResourceManager pastes it in where they #include it. Everything but finding the neighbours
+// lives here: the buffers all of them bind, the force laws, the boundaries and the validation.
+// Specialization constants, ResourceManager injects the values of a variant after the #version line
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 256
+#endif
+// Types in use rounded up to a power of two, their forces are then staged in shared memory.
+// 0 reads the force matrix from the buffer and works for any type count.
+#ifndef TYPE_COUNT
+#define TYPE_COUNT 0
+#endif
+// 0 = wrap, 1 = clamp, 2 = reflect, see BoundaryMode
+#ifndef BOUNDARY_MODE
+#define BOUNDARY_MODE 0
+#endif
+// 0 = smoothstep, 1 = beta, 2 = inverse square, see ForceLaw
+#ifndef FORCE_LAW
+#define FORCE_LAW 0
+#endif
+// 1 counts the pairs each particle tests and finds in range, see StepObservables
+#ifndef COLLECT_OBSERVABLES
+#define COLLECT_OBSERVABLES 0
+#endif
+
+layout(std430, binding = 0) buffer PositionsIn {
+  vec2 positionsIn[];
+};
+
+layout(std430, binding = 1) buffer PositionsOut {
+  vec2 positionsOut[];
+};
+
+layout(std430, binding = 2) buffer Velocities {
+  vec2 velocities[];
+};
+
+layout(std430, binding = 3) buffer TypeIds {
+  int typeIds[];  
+};
+
+layout(std430, binding = 4) buffer Forces {
+  float forces[];
+};
+
+// Reset by the host before every batch of steps: invalidCount = 0, firstInvalid = 0xFFFFFFFF
+layout(std430, binding = 11) buffer Validation {
+  uint invalidCount;
+  uint firstInvalid;
+};
+
+#if COLLECT_OBSERVABLES
+// Reset by the host before the step, 64 bit counters as low and high word. observables.comp
+// declares the rest of the block.
+layout(std430, binding = 12) buffer Observables {
+  uint pairsTested[2];
+  uint pairsInRange[2];
+};
+
+// GLSL has no 64 bit atomics, whoever wraps the low word carries into the high one
+#define ATOMIC_ADD_64(counter, value) if (atomicAdd(counter[0], value) > 0xFFFFFFFFu - (value)) atomicAdd(counter[1], 1u)
+#endif
+
+#include "sim_params.glsl"
+
+// Changes every step, kept out of the block
+uniform uint validationSeed;
+
+#if TYPE_COUNT > 0
+shared float forceTable[TYPE_COUNT * TYPE_COUNT];
+#define FORCE(actedType, actingType) forceTable[(actedType) * TYPE_COUNT + (actingType)]
+#else
+#define FORCE(actedType, actingType) forces[(actedType) * maxTypeCount + (actingType)]
+#endif
+
+// Every invocation of the workgroup has to get here before any of them returns
+void loadForceTable() {
+#if TYPE_COUNT > 0
+  for (uint i = gl_LocalInvocationID.x; i < TYPE_COUNT * TYPE_COUNT; i += WORKGROUP_SIZE)
+    forceTable[i] = forces[(i / TYPE_COUNT) * maxTypeCount + i % TYPE_COUNT];
+  memoryBarrierShared();
+  barrier();
+#endif
+}
+
+// Signed force between two particles dist apart, before forceMultiplier. Mirrors force_law.h.
+float forceLaw(float attraction, float dist) {
+#if FORCE_LAW == 1
+  if (dist < innerRadius)
+    return dist / innerRadius - 1.0;
+  return attraction * (1.0 - abs(2.0 * dist - gravityRadius - innerRadius) / (gravityRadius - innerRadius));
+#elif FORCE_LAW == 2
+  float ratio = min(innerRadius / dist, 1.0);
+  return attraction * ratio * ratio;
+#else
+  return attraction * smoothstep(gravityRadius, gravityRadius / 100, dist);
+#endif
+}
+
+uint pcgHash(uint value) {
+  uint state = value * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// Moves particle id from position by the summed force, applies the boundary and the invalid
+// particle policy and writes the new position
+void integrateParticle(uint id, vec2 position, vec2 finalForce) {
+  velocities[id] += finalForce * delta;
+  velocities[id] *= pow(friction, delta);
+  vec2 forcedPosition = position + velocities[id] * delta;
+
+#if BOUNDARY_MODE == 0
+  float xBoundaryMax = display.x + particleRadius;
+  float xBoundaryMin = -particleRadius;
+  float yBoundaryMax = display.y + particleRadius;
+  float yBoundaryMin = -particleRadius;
+
+  if (forcedPosition.x > xBoundaryMax) {
+    forcedPosition.x = mod(forcedPosition.x, xBoundaryMax) + xBoundaryMin;
+  } else if (forcedPosition.x < xBoundaryMin) {
+    forcedPosition.x = xBoundaryMax - mod(-forcedPosition.x, xBoundaryMax) - xBoundaryMin;
+  }
+
+  if (forcedPosition.y > yBoundaryMax) {
+    forcedPosition.y = mod(forcedPosition.y, yBoundaryMax) + yBoundaryMin;
+  } else if (forcedPosition.y < yBoundaryMin) {
+    forcedPosition.y = yBoundaryMax - mod(-forcedPosition.y, yBoundaryMax) - yBoundaryMin;
+  }
+#else
+  // Axes that left [0, display] lose (clamp) or mirror (reflect) their velocity
+  bvec2 outside = bvec2(forcedPosition.x < 0.0 || forcedPosition.x > display.x, forcedPosition.y < 0.0 || forcedPosition.y > display.y);
+#if BOUNDARY_MODE == 1
+  velocities[id] = mix(velocities[id], vec2(0.0), outside);
+#else
+  forcedPosition = mix(forcedPosition, mix(-forcedPosition, 2.0 * vec2(display) - forcedPosition, greaterThan(forcedPosition, vec2(display))), outside);
+  velocities[id] = mix(velocities[id], -velocities[id], outside);
+#endif
+  forcedPosition = clamp(forcedPosition, vec2(0.0), vec2(display));
+#endif
+  
+  // Non-finite state is counted for the host and optionally repaired, see InvalidParticlePolicy
+  vec2 velocity = velocities[id];
+  if (any(isnan(forcedPosition)) || any(isinf(forcedPosition)) || any(isnan(velocity)) || any(isinf(velocity))) {
+    atomicAdd(invalidCount, 1u);
+    atomicMin(firstInvalid, id);
+    if (invalidPolicy == 1) {
+      // Clamp: stay where the particle was, or at the display centre when that is lost as well
+      vec2 previous = positionsIn[id];
+      bool previousValid = !(any(isnan(previous)) || any(isinf(previous)));
+      forcedPosition = previousValid ? clamp(previous, vec2(0.0), vec2(display)) : vec2(display) * 0.5;
+      velocities[id] = vec2(0.0);
+    } else if (invalidPolicy == 2) {
+      // Respawn at a random position at rest
+      vec2 draw = vec2(pcgHash(id ^ pcgHash(validationSeed)), pcgHash(id ^ pcgHash(validationSeed + 0x9E3779B9u)));
+      forcedPosition = vec2(draw / 4294967296.0) * vec2(display);
+      velocities[id] = vec2(0.0);
+    }
+  }
+
+  positionsOut[id] = forcedPosition;
+}
+
+#if COLLECT_OBSERVABLES
+void addPairCounts(uint tested, uint neighbours) {
+  ATOMIC_ADD_64(pairsTested, tested);
+  ATOMIC_ADD_64(pairsInRange, neighbours);
+}
+#endif
\ No newline at end of file
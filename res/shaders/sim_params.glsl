@@ -0,0 +1,19 @@
+// Uniform block of the grid and force shaders, ResourceManager pastes it in where they #include
+// it. Written by the host only when a parameter changes, mirrors GPUPhysicsEngine::SimParams.
+layout(std140, binding = 0) uniform SimParams {
+  ivec2 display;
+  ivec2 gridDimensions;
+  vec2 gridOrigin;
+  float gridCellSize;
+  float delta;
+  float particleRadius;
+  float friction;
+  float gravityRadius;
+  float forceMultiplier;
+  int particleCount;
+  int maxTypeCount;
+  // 0 = report only, 1 = clamp, 2 = respawn
+  int invalidPolicy;
+  // Inner radius of the beta and inverse-square laws
+  float innerRadius;
+};
@@ -0,0 +1,213 @@
+// Headless batch runner: steps a scenario on the CPU backend with a fixed timestep and writes
+// the final particle state plus timings to disk. No window, GL context or ImGui involved.
+//
+// Usage: pl++-batch <scenario> <steps> <dt> <seed> [--output <prefix>] [--threads <n>]
+//                   [--kernel scalar|avx2|avx512] [--scaling] [--metrics] [--resume <snapshot>]
+//                   [--snapshot <path>] [--record <path>] [--record-every <n>]
+// Writes <prefix>.csv (final state) and <prefix>_timing.json, prefix defaults to "batch".
+// --metrics also writes the observables of every step to <prefix>_metrics.csv. --resume starts
+// from a snapshot instead of spawning the scenario, --snapshot saves the final state as one.
+// --record writes every n-th step (default 1) to a trajectory file, waiting for the writer
+// rather than dropping frames.
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/interaction_kernel.h"
+#include "plpp/metrics_writer.h"
+#include "plpp/scaling_report.h"
+#include "plpp/scenario.h"
+#include "plpp/snapshot.h"
+#include "plpp/trajectory_recorder.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  void printUsage()
+  {
+    std::cerr << "Usage: pl++-batch <scenario> <steps> <dt> <seed> [--output <prefix>] [--threads <n>]\n"
+                 "                  [--kernel scalar|avx2|avx512] [--scaling] [--metrics] [--resume <snapshot>]\n"
+                 "                  [--snapshot <path>] [--record <path>] [--record-every <n>]"
+              << std::endl;
+  }
+
+  std::string escapeJson(const std::string &value)
+  {
+    std::string escaped;
+    for (char c : value)
+    {
+      if (c == '"' || c == '\\')
+        escaped += '\\';
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  double secondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  using namespace PLPP;
+
+  if (argc < 5)
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string scenarioPath = argv[1];
+  int steps = std::atoi(argv[2]);
+  float deltaTime = static_cast<float>(std::atof(argv[3]));
+  uint64_t seed = std::strtoull(argv[4], nullptr, 10);
+  std::string outputPrefix = "batch";
+  int threadCount = 0;
+  std::string kernelName;
+  bool reportScaling = false;
+  bool writeMetrics = false;
+  std::string resumePath, snapshotPath, recordPath;
+  int recordInterval = 1;
+
+  for (int i = 5; i < argc; i++)
+  {
+    std::string option = argv[i];
+    if (option == "--output" && i + 1 < argc)
+      outputPrefix = argv[++i];
+    else if (option == "--threads" && i + 1 < argc)
+      threadCount = std::atoi(argv[++i]);
+    else if (option == "--kernel" && i + 1 < argc)
+      kernelName = argv[++i];
+    else if (option == "--scaling")
+      reportScaling = true;
+    else if (option == "--metrics")
+      writeMetrics = true;
+    else if (option == "--resume" && i + 1 < argc)
+      resumePath = argv[++i];
+    else if (option == "--snapshot" && i + 1 < argc)
+      snapshotPath = argv[++i];
+    else if (option == "--record" && i + 1 < argc)
+      recordPath = argv[++i];
+    else if (option == "--record-every" && i + 1 < argc)
+      recordInterval = std::max(std::atoi(argv[++i]), 1);
+    else
+    {
+      printUsage();
+      return 1;
+    }
+  }
+
+  Scenario scenario;
+  if (steps < 0 || deltaTime <= 0.0f || !Scenario::Load(scenarioPath, scenario))
+    return 1;
+
+  CPUPhysicsEngine engine(threadCount);
+  if (!kernelName.empty())
+  {
+    const KernelIsa isas[] = {KernelIsa::Scalar, KernelIsa::AVX2, KernelIsa::AVX512};
+    auto isa = std::find_if(std::begin(isas), std::end(isas), [&](KernelIsa candidate)
+                            { return kernelName == InteractionKernel::GetName(candidate); });
+    if (isa == std::end(isas))
+    {
+      printUsage();
+      return 1;
+    }
+    engine.SetKernelIsa(*isa);
+  }
+
+  // A resumed run takes its parameters, particles and world size from the snapshot
+  auto spawnStart = std::chrono::steady_clock::now();
+  if (!resumePath.empty())
+  {
+    if (!Snapshot::Load(resumePath, engine, &scenario.display))
+      return 1;
+  }
+  else
+  {
+    scenario.Apply(engine, seed);
+    scenario.Spawn(engine, seed);
+  }
+  double spawnSeconds = secondsSince(spawnStart);
+
+  std::cout << std::format("{} particles, {} types, {} threads, {} kernel\n", engine.particleCount, scenario.GetTypeCount(),
+                           engine.GetThreadCount(), InteractionKernel::GetName(engine.GetKernelIsa()));
+
+  if (reportScaling)
+  {
+    std::vector<ScalingSample> samples = ScalingReport::Measure(engine, scenario.display, deltaTime, std::max(1, std::min(steps, 20)),
+                                                                ScalingReport::PowersOfTwo(engine.GetThreadCount()));
+    ScalingReport::Print(std::cout, samples);
+  }
+
+  // Measuring costs a scalar neighbour pass per step, the run time includes it
+  MetricsWriter metrics;
+  if (writeMetrics && !metrics.Open(outputPrefix + "_metrics.csv"))
+    return 1;
+  engine.collectObservables = writeMetrics;
+
+  // Encoding overlaps the next steps, the run time includes reading the particles back
+  TrajectoryRecorder recorder;
+  recorder.dropWhenBusy = false;
+  if (!recordPath.empty() && !recorder.Open(recordPath))
+    return 1;
+
+  std::vector<glm::vec2> positions, velocities;
+  std::vector<int> types;
+  auto runStart = std::chrono::steady_clock::now();
+  for (int step = 0; step < steps; step++)
+  {
+    engine.Update(deltaTime, scenario.display);
+    metrics.Write(engine.GetLastObservables());
+    if (recorder.IsOpen() && (step + 1) % recordInterval == 0)
+    {
+      engine.ReadParticles(positions, velocities, types);
+      recorder.Submit({static_cast<uint64_t>(step + 1), scenario.display, engine.particleRadius, deltaTime, positions, velocities, types});
+    }
+  }
+  double runSeconds = secondsSince(runStart);
+
+  if (recorder.IsOpen())
+  {
+    recorder.Close();
+    TrajectoryStatistics statistics = recorder.GetStatistics();
+    std::cout << std::format("{} frames recorded to {}, {:.1f} MiB, {:.1f}x smaller than floats\n", statistics.framesWritten, recordPath,
+                             statistics.bytesWritten / (1024.0 * 1024.0), statistics.GetCompressionRatio());
+  }
+
+  engine.ReadParticles(positions, velocities, types);
+
+  std::ofstream state(outputPrefix + ".csv");
+  state << "id,type,x,y,vx,vy\n";
+  for (size_t i = 0; i < positions.size(); i++)
+    state << std::format("{},{},{},{},{},{}\n", i, types[i], positions[i].x, positions[i].y, velocities[i].x, velocities[i].y);
+
+  std::ofstream timing(outputPrefix + "_timing.json");
+  timing << std::format("{{\n  \"scenario\": \"{}\",\n  \"particles\": {},\n  \"steps\": {},\n  \"dt\": {},\n  \"seed\": {},\n"
+                        "  \"threads\": {},\n  \"kernel\": \"{}\",\n  \"spawnSeconds\": {},\n  \"runSeconds\": {},\n  \"stepsPerSecond\": {}\n}}\n",
+                        escapeJson(scenarioPath), engine.particleCount, steps, deltaTime, seed, engine.GetThreadCount(),
+                        InteractionKernel::GetName(engine.GetKernelIsa()), spawnSeconds, runSeconds, steps / std::max(runSeconds, 1e-9));
+
+  if (!snapshotPath.empty() && !Snapshot::Save(snapshotPath, engine, scenario.display))
+    return 1;
+
+  if (!state || !timing)
+  {
+    std::cerr << std::format("ERROR::BATCH: Failed to write output '{}'", outputPrefix) << std::endl;
+    return 1;
+  }
+
+  std::cout << std::format("{} steps in {:.3f} s ({:.1f} steps/s), output written to {}.csv\n", steps, runSeconds,
+                           steps / std::max(runSeconds, 1e-9), outputPrefix);
+  return 0;
+}
@@ -0,0 +1,347 @@
+// Benchmark suite: sweeps particle count, active type count and force radius for every backend
+// and kernel variant, reporting throughput, memory and per-phase timings as CSV or JSON.
+// The GPU backend runs in a hidden window, LIBGL_ALWAYS_SOFTWARE=1 selects llvmpipe on Mesa.
+// Run from the project root so the shaders can be found.
+//
+// Usage: pl++_bench [--backends cpu,gpu] [--particles 1000,10000,100000] [--types 1,4,16]
+//                   [--radii 25,50,100] [--steps 20] [--threads n] [--brute-limit 20000]
+//                   [--format csv|json] [--output file]
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/gpu_physics_engine.h"
+#include "plpp/interaction_kernel.h"
+#include "plpp/resource_manager.h"
+#include "plpp/scenario.h"
+
+// External Libraries
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  using namespace PLPP;
+
+  struct BenchmarkResult
+  {
+    std::string backend;
+    std::string variant;
+    int particles;
+    int types;
+    float radius;
+    int steps;
+    double stepsPerSecond;
+    double pairsPerSecond;
+    double pairsPerStep;
+    size_t memoryBytes;
+    double binningMs;
+    double forceMs;
+    double stepMs;
+  };
+
+  struct Variant
+  {
+    std::string backend;
+    std::string name;
+    bool useSpatialGrid;
+    std::function<std::unique_ptr<PhysicsEngine>()> create;
+  };
+
+  std::vector<int> parseIntList(const std::string &list)
+  {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+      values.push_back(std::atoi(item.c_str()));
+    return values;
+  }
+
+  std::vector<float> parseFloatList(const std::string &list)
+  {
+    std::vector<float> values;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+      // Unparsable items become 0, rejected like any other non-positive value
+      try
+      {
+        values.push_back(std::stof(item));
+      }
+      catch (const std::exception &)
+      {
+        values.push_back(0.0f);
+      }
+    }
+    return values;
+  }
+
+  // Empty or non-positive lists would only produce empty or meaningless rows
+  template <typename T>
+  bool allPositive(const std::vector<T> &values)
+  {
+    return !values.empty() && std::all_of(values.begin(), values.end(), [](T value)
+                                          { return value > 0; });
+  }
+
+  // Hidden window, only used for its GL context
+  GLFWwindow *createHeadlessContext()
+  {
+    if (!glfwInit())
+      return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "Particle Life++ Benchmark", NULL, NULL);
+    if (!window)
+      return nullptr;
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+      return nullptr;
+    return window;
+  }
+
+  BenchmarkResult run(const Variant &variant, int particles, int types, float radius, int steps, bool isGpu)
+  {
+    Scenario scenario;
+    scenario.effectiveForceRadius = radius;
+    scenario.useSpatialGrid = variant.useSpatialGrid;
+    scenario.randomForces = true;
+    for (int type = 0; type < types; type++)
+      scenario.particlesPerType.push_back(particles / types + (type < particles % types ? 1 : 0));
+
+    std::unique_ptr<PhysicsEngine> engine = variant.create();
+    scenario.Apply(*engine, 42);
+    scenario.Spawn(*engine, 42);
+
+    const float deltaTime = 1.0f / 60.0f;
+    auto finish = [&]
+    {
+      if (isGpu)
+        glFinish();
+    };
+
+    // Warm up, then time the plain steps
+    for (int step = 0; step < 2; step++)
+      engine->Update(deltaTime, scenario.display);
+    finish();
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++)
+      engine->Update(deltaTime, scenario.display);
+    finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Instrumented steps for the phase breakdown, these may synchronize every step
+    engine->collectStatistics = true;
+    int statisticSteps = std::max(1, std::min(steps, 5));
+    StepStatistics total;
+    for (int step = 0; step < statisticSteps; step++)
+    {
+      engine->Update(deltaTime, scenario.display);
+      const StepStatistics &statistics = engine->GetLastStepStatistics();
+      total.pairsTested += statistics.pairsTested;
+      total.binningSeconds += statistics.binningSeconds;
+      total.forceSeconds += statistics.forceSeconds;
+    }
+
+    BenchmarkResult result;
+    result.backend = variant.backend;
+    result.variant = variant.name;
+    result.particles = engine->particleCount;
+    result.types = types;
+    result.radius = radius;
+    result.steps = steps;
+    result.stepMs = seconds * 1000.0 / steps;
+    result.stepsPerSecond = steps / seconds;
+    result.pairsPerStep = static_cast<double>(total.pairsTested) / statisticSteps;
+    result.pairsPerSecond = result.pairsPerStep * result.stepsPerSecond;
+    result.memoryBytes = engine->GetMemoryFootprint();
+    result.binningMs = total.binningSeconds * 1000.0 / statisticSteps;
+    result.forceMs = total.forceSeconds * 1000.0 / statisticSteps;
+    return result;
+  }
+
+  void writeCsv(std::ostream &out, const std::vector<BenchmarkResult> &results)
+  {
+    out << "backend,variant,particles,types,radius,steps,steps_per_second,pairs_per_second,pairs_per_step,memory_bytes,binning_ms,force_ms,step_ms\n";
+    for (const BenchmarkResult &r : results)
+    {
+      out << std::format("{},{},{},{},{},{},{:.3f},{:.0f},{:.0f},{},{:.4f},{:.4f},{:.4f}\n", r.backend, r.variant, r.particles, r.types, r.radius,
+                         r.steps, r.stepsPerSecond, r.pairsPerSecond, r.pairsPerStep, r.memoryBytes, r.binningMs, r.forceMs, r.stepMs);
+    }
+  }
+
+  void writeJson(std::ostream &out, const std::vector<BenchmarkResult> &results)
+  {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      const BenchmarkResult &r = results[i];
+      out << std::format("  {{\"backend\": \"{}\", \"variant\": \"{}\", \"particles\": {}, \"types\": {}, \"radius\": {}, \"steps\": {}, "
+                         "\"stepsPerSecond\": {:.3f}, \"pairsPerSecond\": {:.0f}, \"pairsPerStep\": {:.0f}, \"memoryBytes\": {}, "
+                         "\"binningMs\": {:.4f}, \"forceMs\": {:.4f}, \"stepMs\": {:.4f}}}{}\n",
+                         r.backend, r.variant, r.particles, r.types, r.radius, r.steps, r.stepsPerSecond, r.pairsPerSecond,
+                         r.pairsPerStep, r.memoryBytes, r.binningMs, r.forceMs, r.stepMs, i + 1 < results.size() ? "," : "");
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string backends = "cpu,gpu";
+  std::vector<int> particleCounts = {1000, 10000, 100000};
+  std::vector<int> typeCounts = {1, 4, 16};
+  std::vector<float> radii = {25.0f, 50.0f, 100.0f};
+  int steps = 20;
+  int threadCount = 0;
+  int bruteLimit = 20000;
+  std::string format = "csv";
+  std::string outputPath;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    std::string option = argv[i];
+    std::string value = argv[i + 1];
+    if (option == "--backends")
+      backends = value;
+    else if (option == "--particles")
+      particleCounts = parseIntList(value);
+    else if (option == "--types")
+      typeCounts = parseIntList(value);
+    else if (option == "--radii")
+      radii = parseFloatList(value);
+    else if (option == "--steps")
+      steps = std::max(1, std::atoi(value.c_str()));
+    else if (option == "--threads")
+      threadCount = std::atoi(value.c_str());
+    else if (option == "--brute-limit")
+      bruteLimit = std::atoi(value.c_str());
+    else if (option == "--format")
+      format = value;
+    else if (option == "--output")
+      outputPath = value;
+    else
+    {
+      std::cerr << std::format("ERROR::BENCH: Unknown option '{}'", option) << std::endl;
+      return 1;
+    }
+  }
+  if (!allPositive(particleCounts) || !allPositive(typeCounts) || !allPositive(radii))
+  {
+    std::cerr << "ERROR::BENCH: --particles, --types and --radii take comma separated positive numbers" << std::endl;
+    return 1;
+  }
+
+  std::vector<Variant> variants;
+  if (backends.find("cpu") != std::string::npos)
+  {
+    for (KernelIsa isa : InteractionKernel::GetSupportedIsas())
+    {
+      auto create = [isa, threadCount]
+      {
+        auto engine = std::make_unique<CPUPhysicsEngine>(threadCount);
+        engine->SetKernelIsa(isa);
+        return std::unique_ptr<PhysicsEngine>(std::move(engine));
+      };
+      variants.push_back({"cpu", "grid-" + InteractionKernel::GetName(isa), true, create});
+      if (isa == InteractionKernel::GetBestIsa())
+      {
+        variants.push_back({"cpu", "brute-" + InteractionKernel::GetName(isa), false, create});
+        auto createAuto = [create]
+        {
+          std::unique_ptr<PhysicsEngine> engine = create();
+          engine->autoSelectKernel = true;
+          return engine;
+        };
+        variants.push_back({"cpu", "auto-" + InteractionKernel::GetName(isa), true, createAuto});
+      }
+    }
+  }
+
+  GLFWwindow *window = nullptr;
+  if (backends.find("gpu") != std::string::npos)
+  {
+    window = createHeadlessContext();
+    if (window)
+    {
+      std::cerr << std::format("GPU backend on {}", reinterpret_cast<const char *>(glGetString(GL_RENDERER))) << std::endl;
+      auto create = [](bool tiled, bool autoSelect, bool specialize)
+      {
+        return [tiled, autoSelect, specialize]
+        {
+          auto engine = std::make_unique<GPUPhysicsEngine>();
+          engine->useTiledKernel = tiled;
+          engine->autoSelectKernel = autoSelect;
+          engine->specializeKernels = specialize;
+          return std::unique_ptr<PhysicsEngine>(std::move(engine));
+        };
+      };
+      // The generic builds read the force matrix from its buffer, the gap to the default is the specialization gain
+      variants.push_back({"gpu", "grid", true, create(true, false, true)});
+      variants.push_back({"gpu", "grid-generic", true, create(true, false, false)});
+      variants.push_back({"gpu", "tiled", false, create(true, false, true)});
+      variants.push_back({"gpu", "tiled-generic", false, create(true, false, false)});
+      variants.push_back({"gpu", "brute", false, create(false, false, true)});
+      variants.push_back({"gpu", "auto", true, create(true, true, true)});
+    }
+    else
+    {
+      std::cerr << "ERROR::BENCH: Failed to create a GL context, skipping the GPU backend" << std::endl;
+    }
+  }
+
+  std::vector<BenchmarkResult> results;
+  for (const Variant &variant : variants)
+  {
+    for (int particles : particleCounts)
+    {
+      if (!variant.useSpatialGrid && particles > bruteLimit)
+        continue;
+      for (int types : typeCounts)
+      {
+        for (float radius : radii)
+        {
+          results.push_back(run(variant, particles, std::min(types, MAXIMUM_PARTICLE_TYPES), radius, steps, variant.backend == "gpu"));
+          const BenchmarkResult &r = results.back();
+          std::cerr << std::format("{:<4} {:<14} n={:<7} types={:<3} radius={:<4} {:>9.2f} steps/s\n", r.backend, r.variant, r.particles,
+                                   r.types, r.radius, r.stepsPerSecond);
+        }
+      }
+    }
+  }
+
+  std::ofstream file;
+  if (!outputPath.empty())
+    file.open(outputPath);
+  std::ostream &out = outputPath.empty() ? std::cout : file;
+  if (format == "json")
+    writeJson(out, results);
+  else
+    writeCsv(out, results);
+
+  if (window)
+  {
+    ResourceManager::StoreProgramBinaries();
+    glfwTerminate();
+  }
+  return 0;
+}
@@ -0,0 +1,461 @@
+#include "plpp/cpu_physics_engine.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/interaction_kernel.h"
+#include "plpp/profiler.h"
+#include "plpp/spatial_grid.h"
+#include "plpp/thread_pool.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace PLPP
+{
+  namespace
+  {
+    // GLSL built-ins, reproduced so results track the compute shader
+    float glslMod(float x, float y)
+    {
+      return x - y * std::floor(x / y);
+    }
+
+    float wrapCoordinate(float value, float boundaryMin, float boundaryMax)
+    {
+      if (value > boundaryMax)
+        return glslMod(value, boundaryMax) + boundaryMin;
+      if (value < boundaryMin)
+        return boundaryMax - glslMod(-value, boundaryMax) - boundaryMin;
+      return value;
+    }
+
+    // Keeps value in [0, size] as the BOUNDARY_MODE branches of the force shaders do, velocity is
+    // stopped or mirrored along the axis
+    float boundCoordinate(BoundaryMode mode, float value, float &velocity, float size)
+    {
+      if (value >= 0.0f && value <= size)
+        return value;
+      if (mode == BoundaryMode::Clamp)
+      {
+        velocity = 0.0f;
+        return std::clamp(value, 0.0f, size);
+      }
+      velocity = -velocity;
+      return std::clamp(value < 0.0f ? -value : 2.0f * size - value, 0.0f, size);
+    }
+  }
+
+  CPUPhysicsEngine::CPUPhysicsEngine(int threadCount)
+      : threadPool_(std::make_unique<ThreadPool>(threadCount))
+  {
+    SetKernelIsa(InteractionKernel::GetBestIsa());
+  }
+
+  void CPUPhysicsEngine::SetThreadCount(int threadCount)
+  {
+    threadPool_ = std::make_unique<ThreadPool>(threadCount);
+  }
+
+  void CPUPhysicsEngine::SetKernelIsa(KernelIsa isa)
+  {
+    kernelIsa_ = InteractionKernel::IsSupported(isa) ? isa : KernelIsa::Scalar;
+    kernel_ = InteractionKernel::Get(kernelIsa_, forceLaw);
+  }
+
+  int CPUPhysicsEngine::appendSlots(int count)
+  {
+    haloCount_ = 0;
+    int first = particleCount;
+    size_t size = static_cast<size_t>(particleCount) + count;
+    positionsInX_.resize(size);
+    positionsInY_.resize(size);
+    positionsOutX_.resize(size);
+    positionsOutY_.resize(size);
+    velocitiesX_.resize(size);
+    velocitiesY_.resize(size);
+    types_.resize(size);
+    particleCount += count;
+    return first;
+  }
+
+  void CPUPhysicsEngine::AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions, std::span<const glm::vec2> velocities)
+  {
+    int count = static_cast<int>(std::min(typeIds.size(), positions.size()));
+    if (!hasValidTypes(typeIds.first(count)))
+    {
+      std::cerr << std::format("ERROR::PHYSICS: particle types have to lie in [0, {}), none of the {} particles added", MAXIMUM_PARTICLE_TYPES, count) << std::endl;
+      return;
+    }
+    int first = appendSlots(count);
+    for (int i = 0; i < count; i++)
+    {
+      positionsInX_[first + i] = positionsOutX_[first + i] = positions[i].x;
+      positionsInY_[first + i] = positionsOutY_[first + i] = positions[i].y;
+      glm::vec2 velocity = i < static_cast<int>(velocities.size()) ? velocities[i] : glm::vec2(0.0f);
+      velocitiesX_[first + i] = velocity.x;
+      velocitiesY_[first + i] = velocity.y;
+      types_[first + i] = typeIds[i];
+    }
+  }
+
+  void CPUPhysicsEngine::SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display)
+  {
+    if (distribution.count <= 0)
+      return;
+
+    std::vector<float> typeThresholds = distribution.GetTypeThresholds();
+    int first = appendSlots(distribution.count);
+    // Every sample only depends on its index, chunks fill their own slots
+    threadPool_->ParallelFor(distribution.count, 4096, [&](int begin, int end)
+                             {
+      for (int i = begin; i < end; i++)
+      {
+        glm::vec2 position = distribution.SamplePosition(i, glm::vec2(display));
+        positionsInX_[first + i] = positionsOutX_[first + i] = position.x;
+        positionsInY_[first + i] = positionsOutY_[first + i] = position.y;
+        velocitiesX_[first + i] = 0.0f;
+        velocitiesY_[first + i] = 0.0f;
+        types_[first + i] = distribution.SampleType(i, typeThresholds);
+      } });
+  }
+
+  void CPUPhysicsEngine::ClearParticles()
+  {
+    particleCount = 0;
+    haloCount_ = 0;
+    for (std::vector<float> *values : {&positionsInX_, &positionsInY_, &positionsOutX_, &positionsOutY_, &velocitiesX_, &velocitiesY_})
+      values->clear();
+    types_.clear();
+  }
+
+  void CPUPhysicsEngine::SetHaloParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions)
+  {
+    haloCount_ = static_cast<int>(std::min(typeIds.size(), positions.size()));
+    size_t size = static_cast<size_t>(particleCount) + haloCount_;
+    positionsInX_.resize(size);
+    positionsInY_.resize(size);
+    types_.resize(size);
+    for (int i = 0; i < haloCount_; i++)
+    {
+      positionsInX_[particleCount + i] = positions[i].x;
+      positionsInY_[particleCount + i] = positions[i].y;
+      types_[particleCount + i] = typeIds[i];
+    }
+  }
+
+  void CPUPhysicsEngine::RemoveParticles(std::span<const int> ids)
+  {
+    if (ids.empty())
+      return;
+
+    // Compacts in place, every survivor moves down by the number of removed ids before it
+    int next = 0;
+    int kept = ids[0];
+    for (int id = ids[0]; id < particleCount; id++)
+    {
+      if (next < static_cast<int>(ids.size()) && ids[next] == id)
+      {
+        next++;
+        continue;
+      }
+      positionsInX_[kept] = positionsInX_[id];
+      positionsInY_[kept] = positionsInY_[id];
+      velocitiesX_[kept] = velocitiesX_[id];
+      velocitiesY_[kept] = velocitiesY_[id];
+      types_[kept] = types_[id];
+      kept++;
+    }
+
+    particleCount = kept;
+    haloCount_ = 0;
+    for (std::vector<float> *values : {&positionsInX_, &positionsInY_, &positionsOutX_, &positionsOutY_, &velocitiesX_, &velocitiesY_})
+      values->resize(particleCount);
+    types_.resize(particleCount);
+  }
+
+  void CPUPhysicsEngine::Update(float deltaTime, glm::ivec2 display)
+  {
+    if (particleCount <= 0)
+    {
+      SetHaloParticles({}, {});
+      return;
+    }
+    PLPP_PROFILE_SCOPE("CPU Step");
+
+    float frictionFactor = std::pow(friction, deltaTime);
+    kernel_ = InteractionKernel::Get(kernelIsa_, forceLaw);
+    auto phaseStart = std::chrono::steady_clock::now();
+
+    bool gridPass = UsesSpatialGrid(display);
+    if (gridPass)
+    {
+      binParticles(display);
+      auto forceStart = std::chrono::steady_clock::now();
+      lastStepStatistics_.binningSeconds = std::chrono::duration<double>(forceStart - phaseStart).count();
+      phaseStart = forceStart;
+
+      // Tasks walk the cell-sorted slots so neighbouring particles share cache lines
+      // Halo particles are binned with the others but only act as sources
+      threadPool_->ParallelFor(particleCount + haloCount_, taskGrainSize, [&](int begin, int end)
+                               {
+        for (int slot = begin; slot < end; slot++)
+        {
+          if (sortedIds_[slot] < particleCount)
+            integrate(sortedIds_[slot], gridForce(slot), deltaTime, frictionFactor, display);
+        } });
+    }
+    else
+    {
+      lastStepStatistics_.binningSeconds = 0.0;
+      threadPool_->ParallelFor(particleCount, taskGrainSize, [&](int begin, int end)
+                               {
+        for (int id = begin; id < end; id++)
+          integrate(id, bruteForce(id), deltaTime, frictionFactor, display); });
+    }
+    lastStepStatistics_.forceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - phaseStart).count();
+
+    stepIndex_++;
+    if (collectObservables)
+      measureObservables(gridPass);
+
+    if (collectStatistics)
+    {
+      // The grid kernel scans whole rows of the 3x3 block, which is exactly the neighbourhood sum
+      lastStepStatistics_.pairsTested = gridPass ? countGridPairs(cellCounts_.data(), gridDimensions_)
+                                                 : static_cast<uint64_t>(particleCount) * (particleCount + haloCount_);
+    }
+
+    if (haloCount_ > 0)
+    {
+      haloCount_ = 0;
+      positionsInX_.resize(particleCount);
+      positionsInY_.resize(particleCount);
+      types_.resize(particleCount);
+    }
+    std::swap(positionsInX_, positionsOutX_);
+    std::swap(positionsInY_, positionsOutY_);
+  }
+
+  void CPUPhysicsEngine::ReadParticles(std::vector<glm::vec2> &positions, std::vector<glm::vec2> &velocities, std::vector<int> &types)
+  {
+    positions.resize(particleCount);
+    velocities.resize(particleCount);
+    for (int id = 0; id < particleCount; id++)
+    {
+      positions[id] = glm::vec2(positionsInX_[id], positionsInY_[id]);
+      velocities[id] = glm::vec2(velocitiesX_[id], velocitiesY_[id]);
+    }
+    types.assign(types_.begin(), types_.begin() + particleCount);
+  }
+
+  size_t CPUPhysicsEngine::GetMemoryFootprint() const
+  {
+    size_t floats = positionsInX_.capacity() + positionsInY_.capacity() + positionsOutX_.capacity() + positionsOutY_.capacity() +
+                    velocitiesX_.capacity() + velocitiesY_.capacity() + sortedX_.capacity() + sortedY_.capacity() + forceMatrix.capacity();
+    size_t ints = types_.capacity() + cellCounts_.capacity() + cellStarts_.capacity() + cellCursors_.capacity() +
+                  particleCells_.capacity() + sortedIds_.capacity() + sortedTypes_.capacity();
+    return floats * sizeof(float) + ints * sizeof(int);
+  }
+
+  void CPUPhysicsEngine::binParticles(glm::ivec2 display)
+  {
+    PLPP_PROFILE_SCOPE("CPU Binning");
+    SpatialGrid grid = SpatialGrid::Fit(display, particleRadius, effectiveForceRadius);
+    gridDimensions_ = grid.dimensions;
+    int binnedCount = particleCount + haloCount_;
+
+    cellCounts_.assign(grid.GetCellCount(), 0);
+    cellStarts_.resize(grid.GetCellCount());
+    particleCells_.resize(binnedCount);
+    sortedIds_.resize(binnedCount);
+    sortedTypes_.resize(binnedCount);
+    sortedX_.resize(binnedCount);
+    sortedY_.resize(binnedCount);
+
+    threadPool_->ParallelFor(binnedCount, 4096, [&](int begin, int end)
+                             {
+      for (int id = begin; id < end; id++)
+      {
+        glm::ivec2 cell = grid.GetCell(glm::vec2(positionsInX_[id], positionsInY_[id]));
+        particleCells_[id] = cell.y * grid.dimensions.x + cell.x;
+      } });
+
+    // Counting sort, cheap next to the force pass so it stays serial
+    for (int id = 0; id < binnedCount; id++)
+      cellCounts_[particleCells_[id]]++;
+
+    int running = 0;
+    for (int cell = 0; cell < grid.GetCellCount(); cell++)
+    {
+      cellStarts_[cell] = running;
+      running += cellCounts_[cell];
+    }
+
+    // Stable scatter, particles keep their relative order inside a cell
+    cellCursors_ = cellStarts_;
+    for (int id = 0; id < binnedCount; id++)
+      sortedIds_[cellCursors_[particleCells_[id]]++] = id;
+
+    threadPool_->ParallelFor(binnedCount, 4096, [&](int begin, int end)
+                             {
+      for (int slot = begin; slot < end; slot++)
+      {
+        sortedX_[slot] = positionsInX_[sortedIds_[slot]];
+        sortedY_[slot] = positionsInY_[sortedIds_[slot]];
+        sortedTypes_[slot] = types_[sortedIds_[slot]];
+      } });
+  }
+
+  glm::vec2 CPUPhysicsEngine::gridForce(int slot) const
+  {
+    InteractionKernelArgs args;
+    args.x = sortedX_.data();
+    args.y = sortedY_.data();
+    args.types = sortedTypes_.data();
+    args.forceRow = &forceMatrix[sortedTypes_[slot] * MAXIMUM_PARTICLE_TYPES];
+    args.targetX = sortedX_[slot];
+    args.targetY = sortedY_[slot];
+    args.targetIndex = slot;
+    args.radius = effectiveForceRadius;
+    args.forceMultiplier = forceMultiplier;
+    args.innerRadius = GetForceInnerRadius();
+
+    int ownCell = particleCells_[sortedIds_[slot]];
+    int cellX = ownCell % gridDimensions_.x;
+    int cellY = ownCell / gridDimensions_.x;
+    int firstColumn = std::max(cellX - 1, 0);
+    int lastColumn = std::min(cellX + 1, gridDimensions_.x - 1);
+
+    // Cells of a row are contiguous in the sorted order, so each row of the 3x3 block is one run
+    glm::vec2 finalForce(0.0f, 0.0f);
+    for (int cy = std::max(cellY - 1, 0); cy <= std::min(cellY + 1, gridDimensions_.y - 1); cy++)
+    {
+      int firstCell = cy * gridDimensions_.x + firstColumn;
+      int lastCell = cy * gridDimensions_.x + lastColumn;
+      finalForce += kernel_(args, cellStarts_[firstCell], cellStarts_[lastCell] + cellCounts_[lastCell]);
+    }
+    return finalForce;
+  }
+
+  glm::vec2 CPUPhysicsEngine::bruteForce(int id) const
+  {
+    InteractionKernelArgs args;
+    args.x = positionsInX_.data();
+    args.y = positionsInY_.data();
+    args.types = types_.data();
+    args.forceRow = &forceMatrix[types_[id] * MAXIMUM_PARTICLE_TYPES];
+    args.targetX = positionsInX_[id];
+    args.targetY = positionsInY_[id];
+    args.targetIndex = id;
+    args.radius = effectiveForceRadius;
+    args.forceMultiplier = forceMultiplier;
+    args.innerRadius = GetForceInnerRadius();
+
+    return kernel_(args, 0, particleCount + haloCount_);
+  }
+
+  void CPUPhysicsEngine::measureObservables(bool gridPass)
+  {
+    PLPP_PROFILE_SCOPE("CPU Observables");
+    StepObservables &observables = lastObservables_;
+    observables.step = stepIndex_;
+    observables.particleCount = particleCount;
+    observables.pairsTested = gridPass ? countGridPairs(cellCounts_.data(), gridDimensions_)
+                                       : static_cast<uint64_t>(particleCount) * (particleCount + haloCount_);
+
+    // Same radius test as the force kernels, against the positions the step started from
+    float radius = effectiveForceRadius;
+    auto inRange = [radius](float x, float y, float otherX, float otherY)
+    {
+      float dist = std::sqrt((otherX - x) * (otherX - x) + (otherY - y) * (otherY - y));
+      return dist > 0.0f && dist < radius;
+    };
+    std::atomic<uint64_t> pairsInRange = 0;
+    if (gridPass)
+    {
+      threadPool_->ParallelFor(particleCount + haloCount_, taskGrainSize, [&](int begin, int end)
+                               {
+        uint64_t pairs = 0;
+        for (int slot = begin; slot < end; slot++)
+        {
+          if (sortedIds_[slot] >= particleCount)
+            continue;
+          int ownCell = particleCells_[sortedIds_[slot]];
+          int cellX = ownCell % gridDimensions_.x, cellY = ownCell / gridDimensions_.x;
+          for (int cy = std::max(cellY - 1, 0); cy <= std::min(cellY + 1, gridDimensions_.y - 1); cy++)
+          {
+            int first = cellStarts_[cy * gridDimensions_.x + std::max(cellX - 1, 0)];
+            int lastCell = cy * gridDimensions_.x + std::min(cellX + 1, gridDimensions_.x - 1);
+            for (int other = first; other < cellStarts_[lastCell] + cellCounts_[lastCell]; other++)
+              pairs += other != slot && inRange(sortedX_[slot], sortedY_[slot], sortedX_[other], sortedY_[other]);
+          }
+        }
+        pairsInRange.fetch_add(pairs, std::memory_order_relaxed); });
+    }
+    else
+    {
+      threadPool_->ParallelFor(particleCount, taskGrainSize, [&](int begin, int end)
+                               {
+        uint64_t pairs = 0;
+        for (int id = begin; id < end; id++)
+        {
+          for (int other = 0; other < particleCount + haloCount_; other++)
+            pairs += other != id && inRange(positionsInX_[id], positionsInY_[id], positionsInX_[other], positionsInY_[other]);
+        }
+        pairsInRange.fetch_add(pairs, std::memory_order_relaxed); });
+    }
+    observables.pairsInRange = pairsInRange.load(std::memory_order_relaxed);
+
+    // The rest describes the state after the step
+    int typeCount = particleCount > 0 ? *std::max_element(types_.begin(), types_.begin() + particleCount) + 1 : 0;
+    std::vector<glm::dvec2> typeSums(typeCount, glm::dvec2(0.0));
+    observables.typeCounts.assign(typeCount, 0);
+    observables.kineticEnergy = 0.0;
+    for (int id = 0; id < particleCount; id++)
+    {
+      observables.kineticEnergy += 0.5 * (static_cast<double>(velocitiesX_[id]) * velocitiesX_[id] + static_cast<double>(velocitiesY_[id]) * velocitiesY_[id]);
+      typeSums[types_[id]] += glm::dvec2(positionsOutX_[id], positionsOutY_[id]);
+      observables.typeCounts[types_[id]]++;
+    }
+    observables.typeCentroids.assign(typeCount, glm::vec2(0.0f));
+    for (int type = 0; type < typeCount; type++)
+    {
+      if (observables.typeCounts[type] > 0)
+        observables.typeCentroids[type] = glm::vec2(typeSums[type] / static_cast<double>(observables.typeCounts[type]));
+    }
+  }
+
+  void CPUPhysicsEngine::integrate(int id, glm::vec2 finalForce, float deltaTime, float frictionFactor, glm::ivec2 display)
+  {
+    glm::vec2 velocity(velocitiesX_[id], velocitiesY_[id]);
+    velocity += finalForce * deltaTime;
+    velocity *= frictionFactor;
+
+    glm::vec2 position(positionsInX_[id] + velocity.x * deltaTime, positionsInY_[id] + velocity.y * deltaTime);
+    if (boundaryMode == BoundaryMode::Wrap)
+    {
+      float boundaryMin = -particleRadius;
+      position.x = wrapCoordinate(position.x, boundaryMin, display.x + particleRadius);
+      position.y = wrapCoordinate(position.y, boundaryMin, display.y + particleRadius);
+    }
+    else
+    {
+      position.x = boundCoordinate(boundaryMode, position.x, velocity.x, static_cast<float>(display.x));
+      position.y = boundCoordinate(boundaryMode, position.y, velocity.y, static_cast<float>(display.y));
+    }
+    positionsOutX_[id] = position.x;
+    positionsOutY_[id] = position.y;
+    velocitiesX_[id] = velocity.x;
+    velocitiesY_[id] = velocity.y;
+  }
+}
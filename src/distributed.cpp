@@ -0,0 +1,249 @@
+// Multi-process runner: splits a scenario's world into vertical strips and steps each strip in
+// its own worker process on the CPU backend. Workers swap halo and migrating particles with
+// their neighbours through POSIX shared memory every step.
+//
+// Usage: pl++-distributed <scenario> <steps> <dt> <seed> [--workers <n>] [--threads <n>]
+//                         [--output <prefix>] [--weak-scaling]
+// Writes <prefix>.csv (final state, same layout as pl++-batch), prefix defaults to "distributed".
+// --weak-scaling instead repeats the run for 1, 2, 4, ... up to --workers workers, widening the
+// world and its particle count with the worker count, and prints the step times.
+
+// Project Includes
+#include "plpp/halo_exchange.h"
+#include "plpp/scaling_report.h"
+#include "plpp/scenario.h"
+#include "plpp/strip_decomposition.h"
+#include "plpp/subdomain_worker.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// POSIX
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+  using namespace PLPP;
+
+  struct RunResult
+  {
+    bool succeeded = false;
+    int particleCount = 0;
+    // Slowest worker, which every other one waits for at the barriers
+    double secondsPerStep = 0.0;
+    double exchangeSecondsPerStep = 0.0;
+    double migrantsPerStep = 0.0;
+    double haloParticlesPerStep = 0.0;
+    std::vector<ParticleRecord> particles;
+  };
+
+  void printUsage()
+  {
+    std::cerr << "Usage: pl++-distributed <scenario> <steps> <dt> <seed> [--workers <n>] [--threads <n>]\n"
+                 "                        [--output <prefix>] [--weak-scaling]"
+              << std::endl;
+  }
+
+  int runWorker(HaloExchange &exchange, int rank, const Scenario &scenario, uint64_t seed, int threadCount, int steps, float deltaTime)
+  {
+    SubdomainWorker worker(exchange, rank, scenario, seed, threadCount);
+    // Everyone starts the clock together
+    if (!exchange.Arrive())
+      return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++)
+    {
+      if (!worker.Step(deltaTime))
+        return 1;
+    }
+    worker.Finish(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+  }
+
+  // Forks one process per strip and waits for all of them. The launcher itself never starts a
+  // thread, the workers build their thread pools after the fork.
+  RunResult run(const Scenario &scenario, uint64_t seed, int workerCount, int threadCount, int steps, float deltaTime)
+  {
+    RunResult result;
+    result.particleCount = scenario.GetParticleCount();
+    std::unique_ptr<HaloExchange> exchange = HaloExchange::Create(workerCount, std::max(1, result.particleCount));
+    if (!exchange)
+      return result;
+
+    std::cout.flush();
+    std::vector<pid_t> workers;
+    for (int rank = 0; rank < workerCount; rank++)
+    {
+      pid_t pid = fork();
+      if (pid == 0)
+      {
+        int status = 1;
+        try
+        {
+          status = runWorker(*exchange, rank, scenario, seed, threadCount, steps, deltaTime);
+        }
+        catch (const std::exception &exception)
+        {
+          std::cerr << std::format("ERROR::DISTRIBUTED: Worker {} failed: {}", rank, exception.what()) << std::endl;
+        }
+        if (status != 0)
+          exchange->Abort();
+        std::_Exit(status);
+      }
+      if (pid < 0)
+      {
+        std::cerr << std::format("ERROR::DISTRIBUTED: Failed to start worker {}", rank) << std::endl;
+        exchange->Abort();
+        break;
+      }
+      workers.push_back(pid);
+    }
+
+    bool failed = static_cast<int>(workers.size()) != workerCount;
+    for (size_t remaining = workers.size(); remaining > 0; remaining--)
+    {
+      int status = 0;
+      if (waitpid(-1, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      {
+        // Releases the survivors from the barrier
+        exchange->Abort();
+        failed = true;
+      }
+    }
+    if (failed)
+      return result;
+
+    for (int rank = 0; rank < workerCount; rank++)
+    {
+      const WorkerReport &report = exchange->GetReport(rank);
+      result.secondsPerStep = std::max(result.secondsPerStep, report.stepSeconds / std::max(1, steps));
+      result.exchangeSecondsPerStep = std::max(result.exchangeSecondsPerStep, report.exchangeSeconds / std::max(1, steps));
+      result.migrantsPerStep += static_cast<double>(report.migrants) / std::max(1, steps);
+      result.haloParticlesPerStep += static_cast<double>(report.haloParticles) / std::max(1, steps);
+    }
+    std::span<const ParticleRecord> gathered = exchange->GetGathered();
+    result.particles.assign(gathered.begin(), gathered.end());
+    std::sort(result.particles.begin(), result.particles.end(), [](const ParticleRecord &a, const ParticleRecord &b)
+              { return a.id < b.id; });
+    result.succeeded = static_cast<int>(result.particles.size()) == result.particleCount;
+    return result;
+  }
+
+  bool checkWorkerCount(const Scenario &scenario, int workerCount)
+  {
+    int maximumWorkers = StripDecomposition::GetMaximumWorkers(scenario.display, scenario.particleRadius, scenario.effectiveForceRadius);
+    if (workerCount > maximumWorkers)
+    {
+      std::cerr << std::format("ERROR::DISTRIBUTED: {} workers would make strips narrower than the force radius, at most {} fit", workerCount, maximumWorkers) << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 5)
+  {
+    printUsage();
+    return 1;
+  }
+
+  std::string scenarioPath = argv[1];
+  int steps = std::atoi(argv[2]);
+  float deltaTime = static_cast<float>(std::atof(argv[3]));
+  uint64_t seed = std::strtoull(argv[4], nullptr, 10);
+  std::string outputPrefix = "distributed";
+  int workerCount = 1;
+  int threadCount = 1;
+  bool weakScaling = false;
+
+  for (int i = 5; i < argc; i++)
+  {
+    std::string option = argv[i];
+    if (option == "--workers" && i + 1 < argc)
+      workerCount = std::max(1, std::atoi(argv[++i]));
+    else if (option == "--threads" && i + 1 < argc)
+      threadCount = std::atoi(argv[++i]);
+    else if (option == "--output" && i + 1 < argc)
+      outputPrefix = argv[++i];
+    else if (option == "--weak-scaling")
+      weakScaling = true;
+    else
+    {
+      printUsage();
+      return 1;
+    }
+  }
+
+  Scenario scenario;
+  if (steps < 0 || deltaTime <= 0.0f || !Scenario::Load(scenarioPath, scenario))
+    return 1;
+
+  if (weakScaling)
+  {
+    // The scenario describes the strip of a single worker, n workers get n times its width
+    // and particles so the work per worker stays constant
+    std::cout << "workers  particles  ms/step  exchange ms  efficiency  migrants/step  halo/step\n";
+    double baseSeconds = 0.0;
+    for (int workers : ScalingReport::PowersOfTwo(workerCount))
+    {
+      Scenario scaled = scenario;
+      scaled.display.x *= workers;
+      for (int &count : scaled.particlesPerType)
+        count *= workers;
+      if (!checkWorkerCount(scaled, workers))
+        return 1;
+
+      RunResult result = run(scaled, seed, workers, threadCount, steps, deltaTime);
+      if (!result.succeeded)
+        return 1;
+      if (workers == 1)
+        baseSeconds = result.secondsPerStep;
+      std::cout << std::format("{:>7}  {:>9}  {:>7.3f}  {:>11.3f}  {:>9.1f}%  {:>13.1f}  {:>9.1f}\n", workers, result.particleCount,
+                               result.secondsPerStep * 1000.0, result.exchangeSecondsPerStep * 1000.0,
+                               baseSeconds / std::max(result.secondsPerStep, 1e-12) * 100.0, result.migrantsPerStep, result.haloParticlesPerStep);
+    }
+    return 0;
+  }
+
+  if (!checkWorkerCount(scenario, workerCount))
+    return 1;
+
+  std::cout << std::format("{} particles, {} types, {} workers, {} threads each\n", scenario.GetParticleCount(), scenario.GetTypeCount(),
+                           workerCount, threadCount);
+  RunResult result = run(scenario, seed, workerCount, threadCount, steps, deltaTime);
+  if (!result.succeeded)
+  {
+    std::cerr << "ERROR::DISTRIBUTED: Run failed" << std::endl;
+    return 1;
+  }
+
+  std::ofstream state(outputPrefix + ".csv");
+  state << "id,type,x,y,vx,vy\n";
+  for (const ParticleRecord &particle : result.particles)
+    state << std::format("{},{},{},{},{},{}\n", particle.id, particle.type, particle.x, particle.y, particle.vx, particle.vy);
+  if (!state)
+  {
+    std::cerr << std::format("ERROR::DISTRIBUTED: Failed to write output '{}'", outputPrefix) << std::endl;
+    return 1;
+  }
+
+  std::cout << std::format("{} steps in {:.3f} s ({:.1f} steps/s, {:.3f} ms/step exchanging), output written to {}.csv\n", steps,
+                           result.secondsPerStep * steps, 1.0 / std::max(result.secondsPerStep, 1e-12),
+                           result.exchangeSecondsPerStep * 1000.0, outputPrefix);
+  return 0;
+}
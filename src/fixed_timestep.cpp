@@ -0,0 +1,24 @@
+#include "plpp/fixed_timestep.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+
+namespace PLPP
+{
+  int FixedTimestep::Advance(double frameSeconds)
+  {
+    double stepSeconds = 1.0 / std::max(stepsPerSecond, 1);
+    accumulator_ += std::max(frameSeconds, 0.0);
+
+    int steps = static_cast<int>(std::floor(accumulator_ / stepSeconds));
+    steps = std::min(steps, std::max(maxSubsteps, 0));
+    accumulator_ = std::min(accumulator_ - steps * stepSeconds, stepSeconds * 0.999);
+    return steps;
+  }
+
+  float FixedTimestep::GetAlpha() const
+  {
+    return static_cast<float>(accumulator_ * std::max(stepsPerSecond, 1));
+  }
+}
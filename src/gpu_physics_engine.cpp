@@ -0,0 +1,654 @@
+#include "plpp/gpu_physics_engine.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/profiler.h"
+#include "plpp/resource_manager.h"
+#include "plpp/shader.h"
+#include "plpp/spatial_grid.h"
+
+// External Libraries
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace PLPP
+{
+  namespace
+  {
+    // Immutable storage, persistently and coherently mapped for writing when a pointer is requested
+    GLuint createBuffer(size_t size, bool mapped, void **pointer)
+    {
+      GLuint buffer;
+      glGenBuffers(1, &buffer);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+      if (mapped)
+      {
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_COHERENT_BIT | GL_MAP_PERSISTENT_BIT | GL_DYNAMIC_STORAGE_BIT);
+        *pointer = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+      }
+      else
+      {
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, 0);
+      }
+      return buffer;
+    }
+
+    // Replaces buffer with a larger one, carrying the first usedSize bytes over on the GPU.
+    // Deleting the old buffer also releases its persistent mapping
+    void growBuffer(GLuint &buffer, size_t usedSize, size_t size, bool mapped, void **pointer)
+    {
+      GLuint grown = createBuffer(size, mapped, pointer);
+      if (buffer)
+      {
+        if (usedSize > 0)
+        {
+          glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+          glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+          glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+        }
+        glDeleteBuffers(1, &buffer);
+      }
+      buffer = grown;
+    }
+  }
+
+  // Nothing is dispatched before the first spawn or step, the kernels finish compiling behind the first frames
+  GPUPhysicsEngine::GPUPhysicsEngine(int positionRingDepth)
+      : gridCountShader_(ResourceManager::LoadDeferredShader("res/shaders/grid_count.comp", "gridCountShader")),
+        gridScanShader_(ResourceManager::LoadDeferredShader("res/shaders/grid_scan.comp", "gridScanShader")),
+        gridScatterShader_(ResourceManager::LoadDeferredShader("res/shaders/grid_scatter.comp", "gridScatterShader")),
+        seedShader_(ResourceManager::LoadDeferredShader("res/shaders/seed.comp", "seedShader")),
+        observablesShader_(ResourceManager::LoadDeferredShader("res/shaders/observables.comp", "observablesShader"))
+  {
+    // The force matrix has a fixed size, the particle buffers are sized by Reserve
+    size_t forceSize = sizeof(float) * MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES;
+    forcesSSBO_ = createBuffer(forceSize, true, reinterpret_cast<void **>(&forcesPtr_));
+    if (!forcesPtr_)
+      std::cerr << "Failed to map forces buffer!\n";
+
+    paletteSSBO_ = createBuffer(sizeof(glm::vec4) * MAXIMUM_PARTICLE_TYPES, true, reinterpret_cast<void **>(&palettePtr_));
+    if (palettePtr_)
+      std::copy(particleColors.begin(), particleColors.end(), palettePtr_);
+    else
+      std::cerr << "Failed to map palette buffer!\n";
+
+    glGenBuffers(1, &simParamsUBO_);
+    glBindBuffer(GL_UNIFORM_BUFFER, simParamsUBO_);
+    glBufferStorage(GL_UNIFORM_BUFFER, sizeof(SimParams), &simParams_, GL_DYNAMIC_STORAGE_BIT);
+
+    // Spatial grid cell buffers, only ever touched by the GPU
+    glGenBuffers(1, &cellCountsSSBO_);
+    glGenBuffers(1, &cellStartsSSBO_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellCountsSSBO_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * GRID_MAXIMUM_CELLS, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellStartsSSBO_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * GRID_MAXIMUM_CELLS, nullptr, 0);
+
+    positionSlots_.resize(std::max(positionRingDepth, 2));
+    pipelineStatistics_.ringDepth = static_cast<int>(positionSlots_.size());
+    Reserve(INITIAL_PARTICLE_CAPACITY);
+
+    // Validation counters are written by the GPU and read on the host, mapped both ways
+    for (ValidationSlot &slot : validationSlots_)
+    {
+      glGenBuffers(1, &slot.buffer);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+      glBufferStorage(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint), nullptr, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+      slot.counters = reinterpret_cast<GLuint *>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, 2 * sizeof(GLuint), GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+      if (!slot.counters)
+        std::cerr << "Failed to map validation buffer!\n";
+    }
+
+    for (ObservableSlot &slot : observableSlots_)
+    {
+      glGenBuffers(1, &slot.buffer);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+      glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(ObservableBlock), nullptr, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+      slot.block = reinterpret_cast<ObservableBlock *>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ObservableBlock), GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+      if (!slot.block)
+        std::cerr << "Failed to map observables buffer!\n";
+    }
+
+    glGenQueries(3, timerQueries_);
+    prepareForceShaders();
+  }
+
+  GPUPhysicsEngine::~GPUPhysicsEngine()
+  {
+    // The simulator terminates GLFW before its members are destroyed, nothing left to free then
+    if (!glfwGetCurrentContext())
+      return;
+
+    // Deleting a buffer also releases its persistent mapping
+    for (PositionSlot &slot : positionSlots_)
+    {
+      if (slot.fence)
+        glDeleteSync(slot.fence);
+      glDeleteBuffers(1, &slot.buffer);
+    }
+    GLuint buffers[] = {velocitySSBO_, typeSSBO_, forcesSSBO_,
+                        cellCountsSSBO_, cellStartsSSBO_, particleCellsSSBO_, sortedPositionsSSBO_, sortedTypesSSBO_, paletteSSBO_, simParamsUBO_,
+                        observablePartialsSSBO_};
+    glDeleteBuffers(sizeof(buffers) / sizeof(buffers[0]), buffers);
+    for (ValidationSlot &slot : validationSlots_)
+    {
+      if (slot.fence)
+        glDeleteSync(slot.fence);
+      glDeleteBuffers(1, &slot.buffer);
+    }
+    for (ObservableSlot &slot : observableSlots_)
+    {
+      if (slot.fence)
+        glDeleteSync(slot.fence);
+      glDeleteBuffers(1, &slot.buffer);
+    }
+    glDeleteQueries(3, timerQueries_);
+  }
+
+  void GPUPhysicsEngine::AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions, std::span<const glm::vec2> velocities)
+  {
+    int count = static_cast<int>(std::min(typeIds.size(), positions.size()));
+    if (count <= 0)
+      return;
+    if (!hasValidTypes(typeIds.first(count)))
+    {
+      std::cerr << std::format("ERROR::PHYSICS: particle types have to lie in [0, {}), none of the {} particles added", MAXIMUM_PARTICLE_TYPES, count) << std::endl;
+      return;
+    }
+    // The type count becomes the kernels' TYPE_COUNT, every type id stays below it
+    int typeCount = *std::max_element(typeIds.begin(), typeIds.begin() + count) + 1;
+    typeCount_ = std::max(typeCount_, typeCount);
+    prepareForceShaders();
+
+    Reserve(particleCount + count);
+    int first = particleCount;
+    memcpy(positionSlots_[currentSlot_].pointer + first, positions.data(), sizeof(glm::vec2) * count);
+    memcpy(typesPtr_ + first, typeIds.data(), sizeof(int) * count);
+    int givenVelocities = std::min(count, static_cast<int>(velocities.size()));
+    memcpy(velocitiesPtr_ + first, velocities.data(), sizeof(glm::vec2) * givenVelocities);
+    std::fill(velocitiesPtr_ + first + givenVelocities, velocitiesPtr_ + first + count, glm::vec2(0.0f));
+
+    particleCount += count;
+    previousValid_ = false;
+  }
+
+  void GPUPhysicsEngine::SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display)
+  {
+    if (distribution.count <= 0)
+      return;
+
+    Reserve(particleCount + distribution.count);
+    std::vector<float> typeThresholds = distribution.GetTypeThresholds();
+    int typeCount = std::min(static_cast<int>(typeThresholds.size()), MAXIMUM_PARTICLE_TYPES);
+    typeCount_ = std::max(typeCount_, typeCount);
+    prepareForceShaders();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionSlots_[currentSlot_].buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, velocitySSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, typeSSBO_);
+    seedShader_.Use();
+    seedShader_.SetInteger("firstParticle", particleCount);
+    seedShader_.SetInteger("spawnCount", distribution.count);
+    seedShader_.SetUnsigned("seed", distribution.seed);
+    seedShader_.SetVec2f("display", glm::vec2(display));
+    seedShader_.SetInteger("spawnLayout", distribution.layout == SpawnLayout::Clustered ? 1 : 0);
+    seedShader_.SetInteger("clusterCount", distribution.clusterCount);
+    seedShader_.SetFloat("clusterRadius", distribution.clusterRadius);
+    seedShader_.SetInteger("typeCount", typeCount);
+    seedShader_.SetFloats("typeThresholds", typeThresholds.data(), typeCount);
+    seedShader_.Dispatch((distribution.count + 255) / 256);
+
+    particleCount += distribution.count;
+    previousValid_ = false;
+  }
+
+  void GPUPhysicsEngine::ClearParticles()
+  {
+    // Particles added next are written straight into the mapped slots
+    glFinish();
+    particleCount = 0;
+    previousValid_ = false;
+  }
+
+  void GPUPhysicsEngine::Reserve(int capacity)
+  {
+    if (capacity <= capacity_)
+      return;
+
+    // Grow geometrically so a stream of single particle additions reallocates only log(n) times
+    int grownCapacity = std::max(capacity_, INITIAL_PARTICLE_CAPACITY);
+    while (grownCapacity < capacity)
+      grownCapacity *= 2;
+
+    // Shader writes to the buffers being copied from must land before the copies read them
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    size_t usedVec2 = sizeof(glm::vec2) * particleCount, vec2Size = sizeof(glm::vec2) * grownCapacity;
+    size_t usedInt = sizeof(int) * particleCount, intSize = sizeof(int) * grownCapacity;
+    // Only the current slot holds live positions, the others are rewritten before being read
+    bool mapped = true;
+    for (int i = 0; i < static_cast<int>(positionSlots_.size()); i++)
+    {
+      PositionSlot &slot = positionSlots_[i];
+      if (slot.fence)
+      {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+      }
+      growBuffer(slot.buffer, i == currentSlot_ ? usedVec2 : 0, vec2Size, true, reinterpret_cast<void **>(&slot.pointer));
+      mapped = mapped && slot.pointer;
+    }
+    growBuffer(velocitySSBO_, usedVec2, vec2Size, true, reinterpret_cast<void **>(&velocitiesPtr_));
+    growBuffer(typeSSBO_, usedInt, intSize, true, reinterpret_cast<void **>(&typesPtr_));
+    if (!mapped || !velocitiesPtr_ || !typesPtr_)
+      std::cerr << std::format("Failed to map particle buffers for {} particles!\n", grownCapacity);
+
+    // Binning scratch is rebuilt from scratch every step
+    growBuffer(particleCellsSSBO_, 0, sizeof(glm::uvec2) * grownCapacity, false, nullptr);
+    growBuffer(sortedPositionsSSBO_, 0, vec2Size, false, nullptr);
+    growBuffer(sortedTypesSSBO_, 0, intSize, false, nullptr);
+
+    capacity_ = grownCapacity;
+    previousValid_ = false;
+  }
+
+  void GPUPhysicsEngine::Update(float deltaTime, glm::ivec2 display)
+  {
+    Advance(deltaTime, display, 1);
+  }
+
+  void GPUPhysicsEngine::Advance(float deltaTime, glm::ivec2 display, int steps)
+  {
+    if (particleCount <= 0 || steps <= 0)
+      return;
+    PLPP_PROFILE_SCOPE("GPU Steps");
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, velocitySSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, typeSSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, forcesSSBO_);
+
+    // Parameters are fixed for the whole batch and shared by the grid and force passes
+    bool gridPass = UsesSpatialGrid(display);
+    KernelVariant variant = selectVariant(gridPass);
+    SimParams params;
+    params.display = display;
+    if (gridPass)
+    {
+      SpatialGrid grid = SpatialGrid::Fit(display, particleRadius, effectiveForceRadius);
+      params.gridDimensions = grid.dimensions;
+      params.gridOrigin = grid.origin;
+      params.gridCellSize = grid.cellSize;
+    }
+    params.delta = deltaTime;
+    params.particleRadius = particleRadius;
+    params.friction = friction;
+    params.gravityRadius = effectiveForceRadius;
+    params.forceMultiplier = forceMultiplier;
+    params.particleCount = particleCount;
+    params.maxTypeCount = MAXIMUM_PARTICLE_TYPES;
+    params.invalidPolicy = static_cast<int>(invalidParticlePolicy);
+    params.innerRadius = GetForceInnerRadius();
+    uploadSimParams(params);
+    // One validation and one observables slot for the whole batch, so a frame running many substeps
+    // never waits on a step it just issued. Only the last step measures its observables, the others
+    // run the variant without the pair counters.
+    beginValidation();
+    bool sampleObservables = variant.observables && beginObservables();
+    KernelVariant stepVariant = variant;
+    stepVariant.observables = false;
+    Shader &forceShader = getForceShader(stepVariant);
+    Shader &lastForceShader = sampleObservables ? getForceShader(variant) : forceShader;
+
+    for (int step = 0; step < steps; step++)
+    {
+      int nextSlot = (currentSlot_ + 1) % static_cast<int>(positionSlots_.size());
+      acquireSlot(positionSlots_[nextSlot]);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionSlots_[currentSlot_].buffer);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, positionSlots_[nextSlot].buffer);
+
+      if (collectStatistics)
+        glQueryCounter(timerQueries_[0], GL_TIMESTAMP);
+      if (gridPass)
+        binParticles();
+
+      bool lastStep = step == steps - 1;
+      Shader &shader = lastStep ? lastForceShader : forceShader;
+      shader.Use();
+      shader.SetUnsigned("validationSeed", static_cast<uint32_t>(stepIndex_));
+
+      if (collectStatistics)
+        glQueryCounter(timerQueries_[1], GL_TIMESTAMP);
+      shader.Dispatch((particleCount + variant.workgroupSize - 1) / variant.workgroupSize);
+      stepIndex_++;
+      if (lastStep && sampleObservables)
+        reduceObservables(positionSlots_[nextSlot].buffer);
+      if (collectStatistics)
+      {
+        glQueryCounter(timerQueries_[2], GL_TIMESTAMP);
+        collectStepStatistics(params.gridDimensions);
+      }
+
+      currentSlot_ = nextSlot;
+    }
+
+    ValidationSlot &slot = validationSlots_[validationBatch_++ % VALIDATION_READBACK_LATENCY];
+    // Shader writes to the mapped counters must be visible to the host once the fence signals
+    glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.step = stepIndex_ - 1;
+    previousValid_ = true;
+  }
+
+  void GPUPhysicsEngine::ReadParticles(std::vector<glm::vec2> &positions, std::vector<glm::vec2> &velocities, std::vector<int> &types)
+  {
+    // The mappings are write-only, the shaders' results are read back through GL instead. The
+    // barrier orders the readback after the last dispatch's storage writes.
+    positions.resize(particleCount);
+    velocities.resize(particleCount);
+    types.resize(particleCount);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, positionSlots_[currentSlot_].buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(glm::vec2) * particleCount, positions.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, velocitySSBO_);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(glm::vec2) * particleCount, velocities.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, typeSSBO_);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int) * particleCount, types.data());
+  }
+
+  size_t GPUPhysicsEngine::GetMemoryFootprint() const
+  {
+    size_t particleBytes = ((positionSlots_.size() + 1) * sizeof(glm::vec2) + sizeof(int)) * static_cast<size_t>(capacity_);
+    size_t gridBytes = 2 * sizeof(GLuint) * GRID_MAXIMUM_CELLS + (sizeof(glm::uvec2) + sizeof(glm::vec2) + sizeof(int)) * static_cast<size_t>(capacity_);
+    size_t forceBytes = sizeof(float) * MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES;
+    size_t paletteBytes = sizeof(glm::vec4) * MAXIMUM_PARTICLE_TYPES;
+    return particleBytes + gridBytes + forceBytes + paletteBytes;
+  }
+
+  void GPUPhysicsEngine::FencePositions()
+  {
+    // Replacing the fences also covers frames drawn while paused, only the latest draw matters
+    int depth = static_cast<int>(positionSlots_.size());
+    for (int slotIndex : {currentSlot_, (currentSlot_ + depth - 1) % depth})
+    {
+      PositionSlot &slot = positionSlots_[slotIndex];
+      if (slot.fence)
+        glDeleteSync(slot.fence);
+      slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+  }
+
+  void GPUPhysicsEngine::acquireSlot(PositionSlot &slot)
+  {
+    pipelineStatistics_.steps++;
+    for (const PositionSlot &other : positionSlots_)
+    {
+      if (other.fence && glClientWaitSync(other.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        pipelineStatistics_.framesInFlight++;
+    }
+    if (!slot.fence)
+      return;
+
+    if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+      PLPP_PROFILE_SCOPE("Position Fence Wait");
+      auto start = std::chrono::steady_clock::now();
+      glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      pipelineStatistics_.stalledSteps++;
+      pipelineStatistics_.stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+
+  void GPUPhysicsEngine::beginValidation()
+  {
+    // Oldest first, so lastValidation_ ends up with the latest finished batch
+    for (int i = 0; i < VALIDATION_READBACK_LATENCY; i++)
+    {
+      ValidationSlot &slot = validationSlots_[(validationBatch_ + i) % VALIDATION_READBACK_LATENCY];
+      if (slot.fence && glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED)
+        readValidation(slot);
+    }
+
+    ValidationSlot &slot = validationSlots_[validationBatch_ % VALIDATION_READBACK_LATENCY];
+    // Still pending a whole ring later: rather than wait, this batch keeps counting into the same
+    // slot and its fence takes over
+    if (slot.fence)
+    {
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+    }
+    else
+    {
+      slot.counters[0] = 0;
+      slot.counters[1] = 0xFFFFFFFFu;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, slot.buffer);
+  }
+
+  void GPUPhysicsEngine::readValidation(ValidationSlot &slot)
+  {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    lastValidation_.step = slot.step;
+    lastValidation_.invalidCount = slot.counters[0];
+    lastValidation_.firstInvalid = slot.counters[1];
+    if (lastValidation_.invalidCount > 0)
+      std::cerr << std::format("Steps up to {}: {} invalid particle states, first at index {}\n",
+                               lastValidation_.step, lastValidation_.invalidCount, lastValidation_.firstInvalid);
+  }
+
+  void GPUPhysicsEngine::PollObservables()
+  {
+    // Oldest first, so lastObservables_ ends up with the latest finished step
+    for (int i = 0; i < OBSERVABLES_READBACK_SLOTS; i++)
+    {
+      ObservableSlot &slot = observableSlots_[(observableBatch_ + i) % OBSERVABLES_READBACK_SLOTS];
+      if (slot.fence && glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED)
+        readObservables(slot);
+    }
+  }
+
+  bool GPUPhysicsEngine::beginObservables()
+  {
+    PollObservables();
+    ObservableSlot &slot = observableSlots_[observableBatch_ % OBSERVABLES_READBACK_SLOTS];
+    // Still pending a whole ring later, the host is too far ahead and this batch goes unmeasured
+    if (slot.fence)
+      return false;
+
+    std::fill(std::begin(slot.block->pairsTested), std::end(slot.block->pairsTested), 0u);
+    std::fill(std::begin(slot.block->pairsInRange), std::end(slot.block->pairsInRange), 0u);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, slot.buffer);
+    return true;
+  }
+
+  void GPUPhysicsEngine::reduceObservables(GLuint positions)
+  {
+    ObservableSlot &slot = observableSlots_[observableBatch_++ % OBSERVABLES_READBACK_SLOTS];
+    int typeCount = std::min(typeCount_, MAXIMUM_PARTICLE_TYPES);
+    int groups = (particleCount + 255) / 256;
+
+    size_t partialsSize = sizeof(glm::vec4) * groups * (typeCount + 1);
+    if (partialsSize > observablePartialsSize_)
+    {
+      growBuffer(observablePartialsSSBO_, 0, partialsSize, false, nullptr);
+      observablePartialsSize_ = partialsSize;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, positions);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, slot.buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, observablePartialsSSBO_);
+
+    observablesShader_.Use();
+    observablesShader_.SetInteger("typeCount", typeCount);
+    observablesShader_.SetInteger("reducePass", 0);
+    observablesShader_.SetInteger("inputCount", particleCount);
+    observablesShader_.Dispatch(groups);
+    observablesShader_.SetInteger("reducePass", 1);
+    observablesShader_.SetInteger("inputCount", groups);
+    observablesShader_.Dispatch(1);
+
+    glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Counted like the CPU backend, the step number is the count of steps taken including this one
+    slot.step = stepIndex_;
+    slot.particleCount = particleCount;
+    slot.typeCount = typeCount;
+  }
+
+  void GPUPhysicsEngine::readObservables(ObservableSlot &slot)
+  {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    if (slot.step < lastObservables_.step)
+      return;
+
+    const ObservableBlock &block = *slot.block;
+    StepObservables &observables = lastObservables_;
+    observables.step = slot.step;
+    observables.particleCount = slot.particleCount;
+    observables.pairsTested = static_cast<uint64_t>(block.pairsTested[1]) << 32 | block.pairsTested[0];
+    observables.pairsInRange = static_cast<uint64_t>(block.pairsInRange[1]) << 32 | block.pairsInRange[0];
+    observables.kineticEnergy = block.kineticEnergy;
+    observables.typeCounts.assign(slot.typeCount, 0);
+    observables.typeCentroids.assign(slot.typeCount, glm::vec2(0.0f));
+    for (int type = 0; type < slot.typeCount; type++)
+    {
+      // Counts stay exact in a float up to 2^24 particles per type
+      observables.typeCounts[type] = static_cast<int>(block.typeSums[type].z + 0.5f);
+      if (block.typeSums[type].z > 0.0f)
+        observables.typeCentroids[type] = glm::vec2(block.typeSums[type]) / block.typeSums[type].z;
+    }
+  }
+
+  void GPUPhysicsEngine::collectStepStatistics(glm::ivec2 gridDimensions)
+  {
+    // Blocks until the step has finished, only meant for benchmarking
+    GLuint64 timestamps[3];
+    for (int i = 0; i < 3; i++)
+      glGetQueryObjectui64v(timerQueries_[i], GL_QUERY_RESULT, &timestamps[i]);
+    lastStepStatistics_.binningSeconds = (timestamps[1] - timestamps[0]) * 1e-9;
+    lastStepStatistics_.forceSeconds = (timestamps[2] - timestamps[1]) * 1e-9;
+
+    if (gridDimensions.x > 0)
+    {
+      std::vector<GLuint> cellCounts(gridDimensions.x * gridDimensions.y);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellCountsSSBO_);
+      glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * cellCounts.size(), cellCounts.data());
+      lastStepStatistics_.pairsTested = countGridPairs(cellCounts.data(), gridDimensions);
+    }
+    else
+    {
+      lastStepStatistics_.pairsTested = static_cast<uint64_t>(particleCount) * particleCount;
+    }
+  }
+
+  GPUPhysicsEngine::KernelVariant GPUPhysicsEngine::selectVariant(bool gridPass) const
+  {
+    KernelVariant variant;
+    variant.kernel = gridPass ? ForceKernel::Grid : useTiledKernel ? ForceKernel::Tiled : ForceKernel::Brute;
+    // Powers of two keep the number of builds down as types are added
+    if (specializeKernels && typeCount_ <= KERNEL_SPECIALIZED_TYPES)
+    {
+      variant.typeCount = 1;
+      while (variant.typeCount < typeCount_)
+        variant.typeCount *= 2;
+    }
+    variant.workgroupSize = std::clamp(workgroupSize / 32 * 32, 32, 1024);
+    variant.boundaryMode = boundaryMode;
+    variant.forceLaw = static_cast<int>(forceLaw);
+    variant.observables = collectObservables;
+    return variant;
+  }
+
+  Shader &GPUPhysicsEngine::getForceShader(const KernelVariant &variant)
+  {
+    auto shader = forceShaders_.find(variant);
+    if (shader != forceShaders_.end())
+      return shader->second;
+
+    const char *file = variant.kernel == ForceKernel::Grid    ? "res/shaders/particles.comp"
+                       : variant.kernel == ForceKernel::Tiled ? "res/shaders/particles_tiled.comp"
+                                                              : "res/shaders/particles_brute.comp";
+    const char *name = variant.kernel == ForceKernel::Grid    ? "computeShader"
+                       : variant.kernel == ForceKernel::Tiled ? "tiledShader"
+                                                              : "bruteForceShader";
+    ShaderDefines defines = {{"TYPE_COUNT", variant.typeCount},
+                             {"WORKGROUP_SIZE", variant.workgroupSize},
+                             {"BOUNDARY_MODE", static_cast<int>(variant.boundaryMode)},
+                             {"FORCE_LAW", variant.forceLaw},
+                             {"COLLECT_OBSERVABLES", variant.observables ? 1 : 0}};
+    std::string variantName = std::format("{}-t{}-w{}-b{}-f{}{}", name, variant.typeCount, variant.workgroupSize,
+                                          static_cast<int>(variant.boundaryMode), variant.forceLaw, variant.observables ? "-o" : "");
+    return forceShaders_.emplace(variant, ResourceManager::LoadDeferredShader(file, variantName, defines)).first->second;
+  }
+
+  void GPUPhysicsEngine::prepareForceShaders()
+  {
+    for (bool gridPass : {true, false})
+    {
+      KernelVariant variant = selectVariant(gridPass);
+      getForceShader(variant);
+      // Steps before the last of a batch skip the observables
+      if (variant.observables)
+      {
+        variant.observables = false;
+        getForceShader(variant);
+      }
+    }
+  }
+
+  void GPUPhysicsEngine::uploadSimParams(const SimParams &params)
+  {
+    if (std::memcmp(&params, &simParams_, sizeof(SimParams)) != 0)
+    {
+      simParams_ = params;
+      glBindBuffer(GL_UNIFORM_BUFFER, simParamsUBO_);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SimParams), &simParams_);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, simParamsUBO_);
+  }
+
+  void GPUPhysicsEngine::binParticles()
+  {
+    PLPP_PROFILE_SCOPE("GPU Binning");
+    // The grid layout comes from the SimParams block uploaded for the batch
+    int cellCount = simParams_.gridDimensions.x * simParams_.gridDimensions.y;
+    int groups = (particleCount + 255) / 256;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, cellCountsSSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, cellStartsSSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particleCellsSSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, sortedPositionsSSBO_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, sortedTypesSSBO_);
+
+    // The last step's shaders wrote the counts, Dispatch's storage barrier does not order them
+    // before a buffer update
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellCountsSSBO_);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(GLuint) * cellCount, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    // 1. Count particles per cell, remembering each particle's rank within its cell
+    gridCountShader_.Use();
+    gridCountShader_.Dispatch(groups);
+
+    // 2. Exclusive prefix sum of the counts gives each cell's first slot
+    gridScanShader_.Use();
+    gridScanShader_.Dispatch(1);
+
+    // 3. Scatter positions and types into cell order
+    gridScatterShader_.Use();
+    gridScatterShader_.Dispatch(groups);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "plpp/gpu_profiler.h"
+
+// Project Includes
+#include "plpp/profiler.h"
+
+// External Libraries
+#include <glad/glad.h>
+
+// C++ Standard Library
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace PLPP
+{
+  std::vector<GLuint> GPUProfiler::queries_[2];
+  std::vector<GPUProfiler::PendingQuery> GPUProfiler::pending_[2];
+  int GPUProfiler::parity_ = 0;
+  bool GPUProfiler::inScope_ = false;
+  uint64_t GPUProfiler::dropped_ = 0;
+
+  void GPUProfiler::EndFrame()
+  {
+    // The other parity holds the previous frame, its queries are reused by the next one
+    parity_ ^= 1;
+    for (const PendingQuery &pending : pending_[parity_])
+    {
+      GLint available = GL_FALSE;
+      glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available)
+      {
+        dropped_++;
+        continue;
+      }
+      GLuint64 nanoseconds = 0;
+      glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &nanoseconds);
+      Profiler::Record({pending.name, pending.start, nanoseconds * 1e-9, 0, 0, true});
+    }
+    pending_[parity_].clear();
+  }
+
+  GPUProfileScope::GPUProfileScope(const char *name)
+      : active_(Profiler::Enabled.load(std::memory_order_relaxed) && !GPUProfiler::inScope_)
+  {
+    if (!active_)
+      return;
+
+    std::vector<GLuint> &queries = GPUProfiler::queries_[GPUProfiler::parity_];
+    std::vector<GPUProfiler::PendingQuery> &pending = GPUProfiler::pending_[GPUProfiler::parity_];
+    if (pending.size() == queries.size())
+    {
+      GLuint query;
+      glGenQueries(1, &query);
+      queries.push_back(query);
+    }
+    GLuint query = queries[pending.size()];
+    pending.push_back({query, name, Profiler::GetSeconds()});
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    GPUProfiler::inScope_ = true;
+  }
+
+  GPUProfileScope::~GPUProfileScope()
+  {
+    if (!active_)
+      return;
+    glEndQuery(GL_TIME_ELAPSED);
+    GPUProfiler::inScope_ = false;
+  }
+}
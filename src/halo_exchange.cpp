@@ -0,0 +1,155 @@
+#include "plpp/halo_exchange.h"
+
+// C++ Standard Library
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace PLPP
+{
+  // The counters are shared between processes, which only works for lock-free atomics
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+  struct HaloExchange::Header
+  {
+    alignas(64) std::atomic<uint32_t> arrived;
+    alignas(64) std::atomic<uint32_t> generation;
+    std::atomic<uint32_t> aborted;
+    std::atomic<uint32_t> gatheredCount;
+  };
+
+  namespace
+  {
+    size_t alignUp(size_t value)
+    {
+      return (value + 63) & ~static_cast<size_t>(63);
+    }
+  }
+
+  std::unique_ptr<HaloExchange> HaloExchange::Create(int workerCount, int capacity)
+  {
+    std::unique_ptr<HaloExchange> exchange(new HaloExchange());
+    exchange->workerCount_ = workerCount;
+    exchange->capacity_ = capacity;
+
+    size_t mailboxCount = 2 * 2 * static_cast<size_t>(workerCount);
+    size_t headerBytes = alignUp(sizeof(Header));
+    size_t reportBytes = alignUp(sizeof(WorkerReport) * workerCount);
+    size_t countBytes = alignUp(sizeof(int) * 2 * mailboxCount);
+    size_t recordBytes = sizeof(ParticleRecord) * capacity * mailboxCount;
+    size_t gatheredBytes = sizeof(ParticleRecord) * capacity;
+    exchange->segmentSize_ = headerBytes + reportBytes + countBytes + recordBytes + gatheredBytes;
+
+    // Unlinked right away, the name only lives long enough to map it and nothing leaks if a
+    // worker dies. Pages are only committed once a mailbox actually fills them.
+    std::string name = std::format("/plpp-halo-{}", getpid());
+    int descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0)
+    {
+      std::cerr << std::format("ERROR::HALO_EXCHANGE: Failed to create shared memory '{}': {}", name, std::strerror(errno)) << std::endl;
+      return nullptr;
+    }
+    shm_unlink(name.c_str());
+
+    void *segment = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(exchange->segmentSize_)) == 0)
+      segment = mmap(nullptr, exchange->segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    int error = errno;
+    close(descriptor);
+    if (segment == MAP_FAILED)
+    {
+      std::cerr << std::format("ERROR::HALO_EXCHANGE: Failed to map {} bytes of shared memory: {}", exchange->segmentSize_, std::strerror(error)) << std::endl;
+      return nullptr;
+    }
+
+    auto *bytes = static_cast<std::byte *>(segment);
+    exchange->segment_ = segment;
+    exchange->header_ = new (bytes) Header{};
+    exchange->reports_ = reinterpret_cast<WorkerReport *>(bytes + headerBytes);
+    exchange->mailboxCounts_ = reinterpret_cast<int *>(bytes + headerBytes + reportBytes);
+    exchange->mailboxRecords_ = reinterpret_cast<ParticleRecord *>(bytes + headerBytes + reportBytes + countBytes);
+    exchange->gathered_ = reinterpret_cast<ParticleRecord *>(bytes + headerBytes + reportBytes + countBytes + recordBytes);
+    return exchange;
+  }
+
+  HaloExchange::~HaloExchange()
+  {
+    munmap(segment_, segmentSize_);
+  }
+
+  size_t HaloExchange::getMailboxIndex(int rank, Direction direction, int parity) const
+  {
+    return (static_cast<size_t>(parity) * workerCount_ + rank) * 2 + (direction == Direction::Right ? 1 : 0);
+  }
+
+  HaloExchange::Mailbox HaloExchange::GetMailbox(int rank, Direction direction, int parity) const
+  {
+    size_t index = getMailboxIndex(rank, direction, parity);
+    return Mailbox{mailboxCounts_[2 * index], mailboxCounts_[2 * index + 1], mailboxRecords_ + index * capacity_};
+  }
+
+  void HaloExchange::PostMailbox(int rank, Direction direction, int parity, int migrantCount, int haloCount)
+  {
+    size_t index = getMailboxIndex(rank, direction, parity);
+    mailboxCounts_[2 * index] = migrantCount;
+    mailboxCounts_[2 * index + 1] = haloCount;
+  }
+
+  bool HaloExchange::Arrive()
+  {
+    uint32_t generation = header_->generation.load(std::memory_order_acquire);
+    if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<uint32_t>(workerCount_))
+    {
+      header_->arrived.store(0, std::memory_order_relaxed);
+      header_->generation.fetch_add(1, std::memory_order_acq_rel);
+      return !IsAborted();
+    }
+    // Workers usually outnumber the cores, so yield instead of spinning hot
+    while (header_->generation.load(std::memory_order_acquire) == generation)
+    {
+      if (IsAborted())
+        return false;
+      std::this_thread::yield();
+    }
+    return !IsAborted();
+  }
+
+  void HaloExchange::Abort()
+  {
+    header_->aborted.store(1, std::memory_order_release);
+  }
+
+  bool HaloExchange::IsAborted() const
+  {
+    return header_->aborted.load(std::memory_order_acquire) != 0;
+  }
+
+  void HaloExchange::Gather(std::span<const ParticleRecord> particles)
+  {
+    uint32_t first = header_->gatheredCount.fetch_add(static_cast<uint32_t>(particles.size()), std::memory_order_acq_rel);
+    std::memcpy(gathered_ + first, particles.data(), particles.size_bytes());
+  }
+
+  std::span<const ParticleRecord> HaloExchange::GetGathered() const
+  {
+    return {gathered_, header_->gatheredCount.load(std::memory_order_acquire)};
+  }
+
+  WorkerReport &HaloExchange::GetReport(int rank) const
+  {
+    return reports_[rank];
+  }
+}
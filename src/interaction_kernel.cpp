@@ -0,0 +1,137 @@
+#include "plpp/interaction_kernel.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace PLPP
+{
+  KernelIsa InteractionKernel::GetBestIsa()
+  {
+    if (IsSupported(KernelIsa::AVX512))
+      return KernelIsa::AVX512;
+    if (IsSupported(KernelIsa::AVX2))
+      return KernelIsa::AVX2;
+    return KernelIsa::Scalar;
+  }
+
+  bool InteractionKernel::IsSupported(KernelIsa isa)
+  {
+    switch (isa)
+    {
+    case KernelIsa::Scalar:
+      return true;
+#if defined(PLPP_X86_KERNELS) && defined(__GNUC__)
+    // libgcc also checks that the OS saves the wider register state
+    case KernelIsa::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case KernelIsa::AVX512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+    }
+  }
+
+  std::vector<KernelIsa> InteractionKernel::GetSupportedIsas()
+  {
+    std::vector<KernelIsa> isas;
+    for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::AVX2, KernelIsa::AVX512})
+    {
+      if (IsSupported(isa))
+        isas.push_back(isa);
+    }
+    return isas;
+  }
+
+  namespace
+  {
+#ifdef PLPP_X86_KERNELS
+    // The vector kernels stay free of glm, the results are turned into vectors here
+    template <typename Law>
+    glm::vec2 accumulateForcesAVX2(const InteractionKernelArgs &args, int begin, int end)
+    {
+      int vectorEnd = begin + std::max(end - begin, 0) / 8 * 8;
+      KernelForce force = AccumulateForcesAVX2<Law>(args, begin, vectorEnd);
+      return glm::vec2(force.x, force.y) + AccumulateForcesScalar<Law>(args, vectorEnd, end);
+    }
+
+    template <typename Law>
+    glm::vec2 accumulateForcesAVX512(const InteractionKernelArgs &args, int begin, int end)
+    {
+      KernelForce force = AccumulateForcesAVX512<Law>(args, begin, end);
+      return glm::vec2(force.x, force.y);
+    }
+#endif
+
+    template <typename Law>
+    InteractionKernelFunction getForLaw(KernelIsa isa)
+    {
+      switch (isa)
+      {
+#ifdef PLPP_X86_KERNELS
+      case KernelIsa::AVX2:
+        return accumulateForcesAVX2<Law>;
+      case KernelIsa::AVX512:
+        return accumulateForcesAVX512<Law>;
+#endif
+      default:
+        return AccumulateForcesScalar<Law>;
+      }
+    }
+  }
+
+  InteractionKernelFunction InteractionKernel::Get(KernelIsa isa, ForceLaw law)
+  {
+    if (!IsSupported(isa))
+      isa = KernelIsa::Scalar;
+
+    switch (law)
+    {
+    case ForceLaw::Beta:
+      return getForLaw<BetaForceLaw>(isa);
+    case ForceLaw::InverseSquare:
+      return getForLaw<InverseSquareForceLaw>(isa);
+    default:
+      return getForLaw<SmoothstepForceLaw>(isa);
+    }
+  }
+
+  std::string InteractionKernel::GetName(KernelIsa isa)
+  {
+    switch (isa)
+    {
+    case KernelIsa::AVX2:
+      return "avx2";
+    case KernelIsa::AVX512:
+      return "avx512";
+    default:
+      return "scalar";
+    }
+  }
+
+  template <typename Law>
+  glm::vec2 AccumulateForcesScalar(const InteractionKernelArgs &args, int begin, int end)
+  {
+    glm::vec2 finalForce(0.0f, 0.0f);
+    for (int i = begin; i < end; i++)
+    {
+      float offsetX = args.x[i] - args.targetX;
+      float offsetY = args.y[i] - args.targetY;
+      float dist = std::sqrt(offsetX * offsetX + offsetY * offsetY);
+      if (dist == 0 || dist >= args.radius || i == args.targetIndex)
+        continue;
+
+      float force = Law::Magnitude(args.forceRow[args.types[i]], dist, args.radius, args.innerRadius) * args.forceMultiplier;
+      finalForce.x += offsetX * (force / dist);
+      finalForce.y += offsetY * (force / dist);
+    }
+    return finalForce;
+  }
+
+  template glm::vec2 AccumulateForcesScalar<SmoothstepForceLaw>(const InteractionKernelArgs &, int, int);
+  template glm::vec2 AccumulateForcesScalar<BetaForceLaw>(const InteractionKernelArgs &, int, int);
+  template glm::vec2 AccumulateForcesScalar<InverseSquareForceLaw>(const InteractionKernelArgs &, int, int);
+}
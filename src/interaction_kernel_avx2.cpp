@@ -0,0 +1,107 @@
+// Compiled with AVX2 + FMA enabled, only called after InteractionKernel::IsSupported says so
+#include "plpp/interaction_kernel.h"
+
+// External Libraries
+#include <immintrin.h>
+
+namespace PLPP
+{
+  namespace
+  {
+    float horizontalSum(__m256 value)
+    {
+      __m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+      sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+      return _mm_cvtss_f32(sum);
+    }
+
+    // Broadcast parameters of the force laws
+    struct LawConstants
+    {
+      __m256 radius;
+      __m256 innerRadius;
+      __m256 inverseInnerRadius;
+      // 1 / (radius / 100 - radius), the smoothstep edges
+      __m256 smoothstepInverseSpan;
+      // 1 / (radius - innerRadius), the width of the beta triangle
+      __m256 betaInverseSpan;
+
+      explicit LawConstants(const InteractionKernelArgs &args)
+          : radius(_mm256_set1_ps(args.radius)),
+            innerRadius(_mm256_set1_ps(args.innerRadius)),
+            inverseInnerRadius(_mm256_set1_ps(1.0f / args.innerRadius)),
+            smoothstepInverseSpan(_mm256_set1_ps(1.0f / (args.radius / 100 - args.radius))),
+            betaInverseSpan(_mm256_set1_ps(1.0f / (args.radius - args.innerRadius))) {}
+    };
+
+    // Vector forms of the policies in force_law.h
+    __m256 magnitude(SmoothstepForceLaw, __m256 attraction, __m256 dist, const LawConstants &law)
+    {
+      __m256 t = _mm256_mul_ps(_mm256_sub_ps(dist, law.radius), law.smoothstepInverseSpan);
+      t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+      __m256 falloff = _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_fnmadd_ps(_mm256_set1_ps(2.0f), t, _mm256_set1_ps(3.0f)));
+      return _mm256_mul_ps(attraction, falloff);
+    }
+
+    __m256 magnitude(BetaForceLaw, __m256 attraction, __m256 dist, const LawConstants &law)
+    {
+      __m256 repulsion = _mm256_fmsub_ps(dist, law.inverseInnerRadius, _mm256_set1_ps(1.0f));
+      __m256 offset = _mm256_sub_ps(_mm256_fmsub_ps(_mm256_set1_ps(2.0f), dist, law.radius), law.innerRadius);
+      offset = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), offset);
+      __m256 peak = _mm256_mul_ps(attraction, _mm256_fnmadd_ps(offset, law.betaInverseSpan, _mm256_set1_ps(1.0f)));
+      return _mm256_blendv_ps(peak, repulsion, _mm256_cmp_ps(dist, law.innerRadius, _CMP_LT_OQ));
+    }
+
+    __m256 magnitude(InverseSquareForceLaw, __m256 attraction, __m256 dist, const LawConstants &law)
+    {
+      __m256 ratio = _mm256_min_ps(_mm256_div_ps(law.innerRadius, dist), _mm256_set1_ps(1.0f));
+      return _mm256_mul_ps(attraction, _mm256_mul_ps(ratio, ratio));
+    }
+  }
+
+  template <typename Law>
+  KernelForce AccumulateForcesAVX2(const InteractionKernelArgs &args, int begin, int end)
+  {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 radius = _mm256_set1_ps(args.radius);
+    const LawConstants law(args);
+    const __m256 forceMultiplier = _mm256_set1_ps(args.forceMultiplier);
+    const __m256 targetX = _mm256_set1_ps(args.targetX);
+    const __m256 targetY = _mm256_set1_ps(args.targetY);
+    const __m256i targetIndex = _mm256_set1_epi32(args.targetIndex);
+    const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256 forceX = zero;
+    __m256 forceY = zero;
+    for (int i = begin; i + 8 <= end; i += 8)
+    {
+      __m256 offsetX = _mm256_sub_ps(_mm256_loadu_ps(args.x + i), targetX);
+      __m256 offsetY = _mm256_sub_ps(_mm256_loadu_ps(args.y + i), targetY);
+      __m256 dist = _mm256_sqrt_ps(_mm256_fmadd_ps(offsetX, offsetX, _mm256_mul_ps(offsetY, offsetY)));
+
+      // dist != 0 && dist < radius && i != targetIndex
+      __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(i), laneOffsets);
+      __m256 isSelf = _mm256_castsi256_ps(_mm256_cmpeq_epi32(indices, targetIndex));
+      __m256 mask = _mm256_and_ps(_mm256_cmp_ps(dist, zero, _CMP_NEQ_OQ), _mm256_cmp_ps(dist, radius, _CMP_LT_OQ));
+      mask = _mm256_andnot_ps(isSelf, mask);
+      if (_mm256_testz_ps(mask, mask))
+        continue;
+
+      // Gathered lookup of forceRow[types[i]]
+      __m256i types = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(args.types + i));
+      __m256 force = _mm256_mask_i32gather_ps(zero, args.forceRow, types, mask, 4);
+
+      __m256 scale = _mm256_div_ps(_mm256_mul_ps(magnitude(Law{}, force, dist, law), forceMultiplier), dist);
+      scale = _mm256_and_ps(scale, mask);
+      forceX = _mm256_fmadd_ps(offsetX, scale, forceX);
+      forceY = _mm256_fmadd_ps(offsetY, scale, forceY);
+    }
+
+    return {horizontalSum(forceX), horizontalSum(forceY)};
+  }
+
+  template KernelForce AccumulateForcesAVX2<SmoothstepForceLaw>(const InteractionKernelArgs &, int, int);
+  template KernelForce AccumulateForcesAVX2<BetaForceLaw>(const InteractionKernelArgs &, int, int);
+  template KernelForce AccumulateForcesAVX2<InverseSquareForceLaw>(const InteractionKernelArgs &, int, int);
+}
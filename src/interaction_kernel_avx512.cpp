@@ -0,0 +1,98 @@
+// Compiled with AVX-512F enabled, only called after InteractionKernel::IsSupported says so
+#include "plpp/interaction_kernel.h"
+
+// External Libraries
+#include <immintrin.h>
+
+namespace PLPP
+{
+  namespace
+  {
+    // Broadcast parameters of the force laws
+    struct LawConstants
+    {
+      __m512 radius;
+      __m512 innerRadius;
+      __m512 inverseInnerRadius;
+      // 1 / (radius / 100 - radius), the smoothstep edges
+      __m512 smoothstepInverseSpan;
+      // 1 / (radius - innerRadius), the width of the beta triangle
+      __m512 betaInverseSpan;
+
+      explicit LawConstants(const InteractionKernelArgs &args)
+          : radius(_mm512_set1_ps(args.radius)),
+            innerRadius(_mm512_set1_ps(args.innerRadius)),
+            inverseInnerRadius(_mm512_set1_ps(1.0f / args.innerRadius)),
+            smoothstepInverseSpan(_mm512_set1_ps(1.0f / (args.radius / 100 - args.radius))),
+            betaInverseSpan(_mm512_set1_ps(1.0f / (args.radius - args.innerRadius))) {}
+    };
+
+    // Vector forms of the policies in force_law.h
+    __m512 magnitude(SmoothstepForceLaw, __m512 attraction, __m512 dist, const LawConstants &law)
+    {
+      __m512 t = _mm512_mul_ps(_mm512_sub_ps(dist, law.radius), law.smoothstepInverseSpan);
+      t = _mm512_min_ps(_mm512_max_ps(t, _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+      __m512 falloff = _mm512_mul_ps(_mm512_mul_ps(t, t), _mm512_fnmadd_ps(_mm512_set1_ps(2.0f), t, _mm512_set1_ps(3.0f)));
+      return _mm512_mul_ps(attraction, falloff);
+    }
+
+    __m512 magnitude(BetaForceLaw, __m512 attraction, __m512 dist, const LawConstants &law)
+    {
+      __m512 repulsion = _mm512_fmsub_ps(dist, law.inverseInnerRadius, _mm512_set1_ps(1.0f));
+      __m512 offset = _mm512_abs_ps(_mm512_sub_ps(_mm512_fmsub_ps(_mm512_set1_ps(2.0f), dist, law.radius), law.innerRadius));
+      __m512 peak = _mm512_mul_ps(attraction, _mm512_fnmadd_ps(offset, law.betaInverseSpan, _mm512_set1_ps(1.0f)));
+      return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(dist, law.innerRadius, _CMP_LT_OQ), peak, repulsion);
+    }
+
+    __m512 magnitude(InverseSquareForceLaw, __m512 attraction, __m512 dist, const LawConstants &law)
+    {
+      __m512 ratio = _mm512_min_ps(_mm512_div_ps(law.innerRadius, dist), _mm512_set1_ps(1.0f));
+      return _mm512_mul_ps(attraction, _mm512_mul_ps(ratio, ratio));
+    }
+  }
+
+  template <typename Law>
+  KernelForce AccumulateForcesAVX512(const InteractionKernelArgs &args, int begin, int end)
+  {
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 radius = _mm512_set1_ps(args.radius);
+    const LawConstants law(args);
+    const __m512 forceMultiplier = _mm512_set1_ps(args.forceMultiplier);
+    const __m512 targetX = _mm512_set1_ps(args.targetX);
+    const __m512 targetY = _mm512_set1_ps(args.targetY);
+    const __m512i targetIndex = _mm512_set1_epi32(args.targetIndex);
+    const __m512i laneOffsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    __m512 forceX = zero;
+    __m512 forceY = zero;
+    for (int i = begin; i < end; i += 16)
+    {
+      // The tail is handled with masked loads instead of a scalar loop
+      __mmask16 valid = end - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (end - i)) - 1);
+      __m512 offsetX = _mm512_sub_ps(_mm512_maskz_loadu_ps(valid, args.x + i), targetX);
+      __m512 offsetY = _mm512_sub_ps(_mm512_maskz_loadu_ps(valid, args.y + i), targetY);
+      __m512 dist = _mm512_sqrt_ps(_mm512_fmadd_ps(offsetX, offsetX, _mm512_mul_ps(offsetY, offsetY)));
+
+      // dist != 0 && dist < radius && i != targetIndex
+      __m512i indices = _mm512_add_epi32(_mm512_set1_epi32(i), laneOffsets);
+      __mmask16 mask = valid & _mm512_cmp_ps_mask(dist, zero, _CMP_NEQ_OQ) & _mm512_cmp_ps_mask(dist, radius, _CMP_LT_OQ);
+      mask &= _mm512_cmpneq_epi32_mask(indices, targetIndex);
+      if (!mask)
+        continue;
+
+      // Gathered lookup of forceRow[types[i]]
+      __m512i types = _mm512_maskz_loadu_epi32(mask, args.types + i);
+      __m512 force = _mm512_mask_i32gather_ps(zero, mask, types, args.forceRow, 4);
+
+      __m512 scale = _mm512_maskz_div_ps(mask, _mm512_mul_ps(magnitude(Law{}, force, dist, law), forceMultiplier), dist);
+      forceX = _mm512_fmadd_ps(offsetX, scale, forceX);
+      forceY = _mm512_fmadd_ps(offsetY, scale, forceY);
+    }
+
+    return {_mm512_reduce_add_ps(forceX), _mm512_reduce_add_ps(forceY)};
+  }
+
+  template KernelForce AccumulateForcesAVX512<SmoothstepForceLaw>(const InteractionKernelArgs &, int, int);
+  template KernelForce AccumulateForcesAVX512<BetaForceLaw>(const InteractionKernelArgs &, int, int);
+  template KernelForce AccumulateForcesAVX512<InverseSquareForceLaw>(const InteractionKernelArgs &, int, int);
+}
@@ -0,0 +1,101 @@
+// Micro-benchmark of the CPU pair interaction kernel, reports pairs/second per force law and instruction set
+// Usage: pl++_kernel_bench [neighbours] [seconds per variant]
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/interaction_kernel.h"
+
+// C++ Standard Library
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  using namespace PLPP;
+
+  int neighbourCount = argc > 1 ? std::atoi(argv[1]) : 1024;
+  double secondsPerVariant = argc > 2 ? std::atof(argv[2]) : 1.0;
+  if (neighbourCount <= 0)
+  {
+    std::cerr << "Usage: pl++_kernel_bench [neighbours] [seconds per variant], neighbours has to be a positive number\n";
+    return 1;
+  }
+  const int targetCount = 256;
+  const int typeCount = 8;
+  const float radius = 50.0f;
+
+  // Neighbours spread over a 3x3 block of cells around the targets, like a grid step sees them
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> coordinate(0.0f, 3.0f * radius);
+  std::uniform_int_distribution<int> type(0, typeCount - 1);
+  std::uniform_real_distribution<float> force(-1.0f, 1.0f);
+
+  std::vector<float> x(neighbourCount), y(neighbourCount);
+  std::vector<int> types(neighbourCount);
+  for (int i = 0; i < neighbourCount; i++)
+  {
+    x[i] = coordinate(rng);
+    y[i] = coordinate(rng);
+    types[i] = type(rng);
+  }
+  std::vector<float> forceMatrix(MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES);
+  for (float &value : forceMatrix)
+    value = force(rng);
+
+  auto runTargets = [&](InteractionKernelFunction kernel, glm::vec2 &checksum)
+  {
+    InteractionKernelArgs args{x.data(), y.data(), types.data(), nullptr, 0.0f, 0.0f, 0, radius, 10.0f, 0.3f * radius};
+    for (int target = 0; target < targetCount; target++)
+    {
+      int index = target % neighbourCount;
+      args.forceRow = &forceMatrix[types[index] * MAXIMUM_PARTICLE_TYPES];
+      args.targetX = x[index];
+      args.targetY = y[index];
+      args.targetIndex = index;
+      checksum += kernel(args, 0, neighbourCount);
+    }
+  };
+
+  std::cout << std::format("{} neighbours, {} targets per pass\n", neighbourCount, targetCount);
+  std::cout << "law            isa       Mpairs/s  ns/pair  checksum delta\n";
+  std::pair<ForceLaw, const char *> laws[] = {{ForceLaw::Smoothstep, "smoothstep"}, {ForceLaw::Beta, "beta"}, {ForceLaw::InverseSquare, "inverse-square"}};
+  for (auto [law, lawName] : laws)
+  {
+    glm::vec2 reference(0.0f, 0.0f);
+    runTargets(InteractionKernel::Get(KernelIsa::Scalar, law), reference);
+
+    for (KernelIsa isa : InteractionKernel::GetSupportedIsas())
+    {
+      InteractionKernelFunction kernel = InteractionKernel::Get(isa, law);
+      glm::vec2 checksum(0.0f, 0.0f);
+      runTargets(kernel, checksum);
+      glm::vec2 delta = checksum - reference;
+
+      long long passes = 0;
+      glm::vec2 sink(0.0f, 0.0f);
+      auto start = std::chrono::steady_clock::now();
+      std::chrono::duration<double> elapsed(0);
+      while (elapsed.count() < secondsPerVariant)
+      {
+        runTargets(kernel, sink);
+        passes++;
+        elapsed = std::chrono::steady_clock::now() - start;
+      }
+      // Keep the results observable so the passes are not optimized away
+      volatile float keep = sink.x + sink.y;
+      (void)keep;
+
+      double pairs = static_cast<double>(passes) * targetCount * neighbourCount;
+      std::cout << std::format("{:<14} {:<8}  {:>8.1f}  {:>7.3f}  {:.2e}\n",
+                               lawName, InteractionKernel::GetName(isa), pairs / elapsed.count() / 1e6,
+                               elapsed.count() * 1e9 / pairs, glm::length(delta));
+    }
+  }
+
+  return 0;
+}
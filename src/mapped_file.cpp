@@ -0,0 +1,118 @@
+#include "plpp/mapped_file.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PLPP
+{
+  bool MappedFile::Open(const std::filesystem::path &path)
+  {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (!mapping)
+      return false;
+    data_ = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    size_ = data_ ? static_cast<size_t>(size.QuadPart) : 0;
+    return data_ != nullptr;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+      return false;
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+      close(file);
+      return false;
+    }
+    void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps the file alive
+    close(file);
+    if (data == MAP_FAILED)
+      return false;
+    data_ = static_cast<const unsigned char *>(data);
+    size_ = static_cast<size_t>(status.st_size);
+    return true;
+#endif
+  }
+
+  void MappedFile::Close()
+  {
+    if (!data_)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(const_cast<unsigned char *>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  void MappedFile::Prefetch(size_t offset, size_t length) const
+  {
+    if (!data_ || offset >= size_)
+      return;
+    length = std::min(length, size_ - offset);
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range{const_cast<unsigned char *>(data_) + offset, length};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise wants a page aligned start
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / page * page;
+    madvise(const_cast<unsigned char *>(data_) + begin, length + offset - begin, MADV_WILLNEED);
+#endif
+  }
+
+  void MappedFile::Touch(size_t offset, size_t length) const
+  {
+    if (!data_ || offset >= size_ || length == 0)
+      return;
+    size_t end = offset + std::min(length, size_ - offset);
+    // No page is smaller than 4 KiB, the volatile reads can't be optimized away
+    const volatile unsigned char *data = data_;
+    unsigned char sink = 0;
+    for (size_t position = offset; position < end; position += 4096)
+      sink ^= data[position];
+    sink ^= data[end - 1];
+    (void)sink;
+  }
+
+  void MappedFile::Release(size_t offset, size_t length) const
+  {
+    if (!data_ || offset >= size_)
+      return;
+    length = std::min(length, size_ - offset);
+#ifdef _WIN32
+    // Unlocking pages that were never locked is how Windows is told they may be trimmed
+    VirtualUnlock(const_cast<unsigned char *>(data_) + offset, length);
+#else
+    // Only whole pages inside the range, the neighbours may still be in use
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + length) / page * page;
+    if (end > begin)
+      madvise(const_cast<unsigned char *>(data_) + begin, end - begin, MADV_DONTNEED);
+#endif
+  }
+}
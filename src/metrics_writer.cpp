@@ -0,0 +1,43 @@
+#include "plpp/metrics_writer.h"
+
+// Project Includes
+#include "plpp/physics_engine.h"
+
+// C++ Standard Library
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace PLPP
+{
+  bool MetricsWriter::Open(const std::filesystem::path &path)
+  {
+    file_.close();
+    file_.open(path, std::ios::trunc);
+    if (!file_)
+    {
+      std::cerr << std::format("ERROR::METRICS: Failed to open '{}'", path.string()) << std::endl;
+      return false;
+    }
+    file_ << "step,particles,pairs_tested,pairs_in_range,mean_neighbours,kinetic_energy,type,type_count,centroid_x,centroid_y\n";
+    lastStep_ = 0;
+    return true;
+  }
+
+  void MetricsWriter::Write(const StepObservables &observables)
+  {
+    if (!file_.is_open() || observables.step == 0 || observables.step <= lastStep_)
+      return;
+    lastStep_ = observables.step;
+
+    std::string stepColumns = std::format("{},{},{},{},{},{}", observables.step, observables.particleCount, observables.pairsTested,
+                                          observables.pairsInRange, observables.GetMeanNeighbours(), observables.kineticEnergy);
+    for (size_t type = 0; type < observables.typeCounts.size(); type++)
+    {
+      file_ << std::format("{},{},{},{},{}\n", stepColumns, type, observables.typeCounts[type],
+                           observables.typeCentroids[type].x, observables.typeCentroids[type].y);
+    }
+  }
+}
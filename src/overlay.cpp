@@ -1,23 +1,30 @@
 #include "plpp/overlay.h"
 
 // Project Includes
+#include "plpp/gpu_physics_engine.h"
+#include "plpp/gpu_profiler.h"
+#include "plpp/profiler.h"
 #include "plpp/settings.h"
 
 // External Libraries
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <imgui.h>
 
 // C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <format>
 #include <iostream>
 #include <string>
 
 namespace PLPP
 {
-  Overlay::Overlay(GLFWwindow *window, PhysicsEngine &physicsEngine_)
-      : window(window), physicsEngine_(physicsEngine_)
+  Overlay::Overlay(GLFWwindow *window, PhysicsEngine &physicsEngine_, FixedTimestep &timestep)
+      : window(window), physicsEngine_(physicsEngine_), timestep_(timestep)
   {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -49,6 +56,8 @@ namespace PLPP
       showMainMenuBar();
     if (settingsAndConfigsMenuEnabled)
       showSettingsAndConfigsMenu();
+    if (profilerMenuEnabled)
+      showProfilerMenu();
     // Rendering
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -61,6 +70,7 @@ namespace PLPP
       if (ImGui::BeginMenu("Windows"))
       {
         ImGui::MenuItem("Settings & Configurations", "CTRL+Q", &settingsAndConfigsMenuEnabled);
+        ImGui::MenuItem("Profiler", nullptr, &profilerMenuEnabled);
         ImGui::EndMenu();
       }
       ImGui::EndMainMenuBar();
@@ -74,6 +84,8 @@ namespace PLPP
       if (ImGui::BeginTabBar("Tabs"))
       {
         settingsMenu();
+        observablesMenu();
+        recordingMenu();
         configurationMenu();
         ImGui::EndTabBar();
       }
@@ -81,6 +93,138 @@ namespace PLPP
     ImGui::End();
   }
 
+  void Overlay::showProfilerMenu()
+  {
+    if (ImGui::Begin("Profiler", &profilerMenuEnabled))
+    {
+#ifdef PLPP_PROFILING
+      bool recording = Profiler::Enabled.load(std::memory_order_relaxed);
+      if (ImGui::Checkbox("Record Scopes", &recording))
+        Profiler::Enabled.store(recording, std::memory_order_relaxed);
+
+      static int captureFrames = 120;
+      ImGui::InputInt("Frames", &captureFrames);
+      captureFrames = std::max(captureFrames, 1);
+      ImGui::BeginDisabled(!recording || Profiler::IsCapturing());
+      if (ImGui::Button("Capture Chrome Trace"))
+        Profiler::CaptureTrace(captureFrames, "plpp_trace.json");
+      ImGui::EndDisabled();
+      std::filesystem::path lastTrace = Profiler::GetLastTrace();
+      if (!lastTrace.empty())
+        ImGui::Text(std::format("Last Trace: {}", lastTrace.string()).c_str());
+      ImGui::Text(std::format("Dropped GPU Queries: {}", GPUProfiler::GetDroppedCount()).c_str());
+
+      // Milliseconds per frame, summed over every time a phase ran in the frame
+      if (ImGui::BeginTable("Phases", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+      {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Clock");
+        ImGui::TableSetupColumn("Last (ms)");
+        ImGui::TableSetupColumn("Average (ms)");
+        ImGui::TableSetupColumn("Maximum (ms)");
+        ImGui::TableHeadersRow();
+        for (const PhaseStatistics &phase : Profiler::GetPhases())
+        {
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(phase.name);
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(phase.gpu ? "GPU" : "CPU");
+          ImGui::TableNextColumn();
+          ImGui::Text(std::format("{:.3f}", phase.lastSeconds * 1000.0).c_str());
+          ImGui::TableNextColumn();
+          ImGui::Text(std::format("{:.3f}", phase.averageSeconds * 1000.0).c_str());
+          ImGui::TableNextColumn();
+          ImGui::Text(std::format("{:.3f}", phase.maximumSeconds * 1000.0).c_str());
+        }
+        ImGui::EndTable();
+      }
+#else
+      ImGui::TextUnformatted("Profiling is compiled out, configure with -DPLPP_PROFILING=ON");
+#endif
+    }
+    ImGui::End();
+  }
+
+  void Overlay::observablesMenu()
+  {
+    if (ImGui::BeginTabItem("Observables"))
+    {
+      ImGui::Checkbox("Measure Observables", &observablesEnabled);
+      ImGui::Checkbox("Write plpp_metrics.csv", &metricsFileEnabled);
+      metricsFileEnabled = metricsFileEnabled && observablesEnabled;
+      if (observablesEnabled && observables.step > 0)
+      {
+        ImGui::Text(std::format("Step {}: {} particles", observables.step, observables.particleCount).c_str());
+        ImGui::Text(std::format("Pairs Tested: {}, In Range: {} ({:.2f}%)", observables.pairsTested, observables.pairsInRange,
+                                observables.pairsTested ? 100.0 * observables.pairsInRange / observables.pairsTested : 0.0)
+                        .c_str());
+        ImGui::Text(std::format("Mean Neighbours: {:.2f}, Kinetic Energy: {:.4g}", observables.GetMeanNeighbours(), observables.kineticEnergy).c_str());
+        if (ImGui::BeginTable("Centroids", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+          ImGui::TableSetupColumn("Type");
+          ImGui::TableSetupColumn("Particles");
+          ImGui::TableSetupColumn("Centroid X");
+          ImGui::TableSetupColumn("Centroid Y");
+          ImGui::TableHeadersRow();
+          for (size_t type = 0; type < observables.typeCounts.size(); type++)
+          {
+            if (observables.typeCounts[type] == 0)
+              continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text(std::format("{}", type).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text(std::format("{}", observables.typeCounts[type]).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text(std::format("{:.1f}", observables.typeCentroids[type].x).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text(std::format("{:.1f}", observables.typeCentroids[type].y).c_str());
+          }
+          ImGui::EndTable();
+        }
+      }
+      ImGui::EndTabItem();
+    }
+  }
+
+  void Overlay::recordingMenu()
+  {
+    if (ImGui::BeginTabItem("Recording"))
+    {
+      // The file being replayed can't be recorded over
+      ImGui::BeginDisabled(replayEnabled);
+      ImGui::Checkbox(std::format("Record {}", TRAJECTORY_FILE).c_str(), &recordingEnabled);
+      ImGui::EndDisabled();
+      ImGui::InputInt("Steps per Frame", &recordInterval);
+      recordInterval = std::max(recordInterval, 1);
+      if (recording.framesWritten > 0 || recording.framesDropped > 0)
+      {
+        ImGui::Text(std::format("Frames Written: {} ({} keyframes), Dropped: {}", recording.framesWritten, recording.keyframesWritten,
+                                recording.framesDropped)
+                        .c_str());
+        ImGui::Text(std::format("{:.1f} MiB written, {:.1f}x smaller than floats", recording.bytesWritten / (1024.0 * 1024.0),
+                                recording.GetCompressionRatio())
+                        .c_str());
+      }
+
+      ImGui::Separator();
+      ImGui::Checkbox(std::format("Replay {}", TRAJECTORY_FILE).c_str(), &replayEnabled);
+      if (replayEnabled)
+      {
+        if (ImGui::Button(replayPaused ? "Play" : "Pause"))
+          replayPaused = !replayPaused;
+        ImGui::SameLine();
+        ImGui::DragFloat("Speed", &replaySpeed, 0.05f, 0.0f, 64.0f, "%.2fx");
+        replaySpeed = std::clamp(replaySpeed, 0.0f, 64.0f);
+        double firstStep = static_cast<double>(replayFirstStep), lastStep = static_cast<double>(replayLastStep);
+        if (ImGui::SliderScalar("Step", ImGuiDataType_Double, &replayPlayhead, &firstStep, &lastStep, "%.0f"))
+          replaySeekRequested = true;
+      }
+      ImGui::EndTabItem();
+    }
+  }
+
   void Overlay::configurationMenu()
   {
     // Generate an adjacency matrix of particles
@@ -128,18 +272,15 @@ namespace PLPP
           {
             ImGui::ColorPicker4(
                 std::format("Select color for particle type {}", row).c_str(),
-                glm::value_ptr(physicsEngine_.particleColors[row]),
+                glm::value_ptr(physicsEngine_.GetParticleColor(row)),
                 ImGuiWindowFlags_AlwaysAutoResize);
             if (ImGui::Button("Close"))
-            {
-              physicsEngine_.UpdateColors();
               ImGui::CloseCurrentPopup();
-            }
             ImGui::EndPopup();
           }
 
           // Doesn't work for some reason. TODO: Fix to make header cells colored.
-          // glm::vec4 color = physicsEngine_.particleColors[row];
+          // glm::vec4 color = physicsEngine_.GetParticleColor(row);
           // ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(color.r, color.g, color.b, color.a));
 
           for (int column = 0; column < particleCount; column++)
@@ -176,6 +317,33 @@ namespace PLPP
       ImGui::DragFloat("Particle Size", &physicsEngine_.particleRadius, 1.0f, 1.0f, 200.0f);
       ImGui::DragFloat("Particle Maximum Affected Radius", &physicsEngine_.effectiveForceRadius, 10.0, 1.0f, 500.0f);
       ImGui::DragFloat("Force Multiplier", &physicsEngine_.forceMultiplier, 0.1f, 0.0f, 100.0f);
+
+      const char *boundaryModes[] = {"Wrap", "Clamp", "Reflect"};
+      if (ImGui::BeginCombo("Boundary", boundaryModes[static_cast<int>(physicsEngine_.boundaryMode)]))
+      {
+        for (int i = 0; i < 3; i++)
+        {
+          if (ImGui::Selectable(boundaryModes[i], static_cast<int>(physicsEngine_.boundaryMode) == i))
+            physicsEngine_.boundaryMode = static_cast<BoundaryMode>(i);
+        }
+        ImGui::EndCombo();
+      }
+
+      const char *forceLaws[] = {"Smoothstep", "Beta", "Inverse Square"};
+      if (ImGui::BeginCombo("Force Law", forceLaws[static_cast<int>(physicsEngine_.forceLaw)]))
+      {
+        for (int i = 0; i < 3; i++)
+        {
+          if (ImGui::Selectable(forceLaws[i], static_cast<int>(physicsEngine_.forceLaw) == i))
+            physicsEngine_.forceLaw = static_cast<ForceLaw>(i);
+        }
+        ImGui::EndCombo();
+      }
+      ImGui::DragFloat("Force Law Inner Radius", &physicsEngine_.forceLawInnerRadius, 0.005f, 0.01f, 0.99f);
+      ImGui::Checkbox("Spatial Grid Binning", &physicsEngine_.useSpatialGrid);
+      ImGui::Checkbox("Automatic Kernel Selection", &physicsEngine_.autoSelectKernel);
+      ImGui::DragInt("Simulation Steps/s", &timestep_.stepsPerSecond, 1.0f, 1, 1000);
+      ImGui::DragInt("Maximum Substeps per Frame", &timestep_.maxSubsteps, 0.1f, 1, 64);
       ImGui::EndTabItem();
     }
   }
@@ -185,7 +353,18 @@ namespace PLPP
     static int currentResolution = 0;
     if (ImGui::BeginTabItem("Settings"))
     {
-      ImGui::Text(std::format("Particle Count: {}", physicsEngine_.particleCount).c_str());
+      ImGui::Text(std::format("Particle Count: {}", particleCount).c_str());
+      ImGui::Text(std::format("Render: {:.1f} frames/s, Simulation: {:.1f} steps/s", frameRate, stepRate).c_str());
+      ImGui::Checkbox("Simulation Thread (CPU Backend)", &simulationThreadEnabled);
+      auto *gpuEngine = dynamic_cast<GPUPhysicsEngine *>(&physicsEngine_);
+      if (gpuEngine && !simulationThreadEnabled)
+      {
+        const PipelineStatistics &pipeline = gpuEngine->GetPipelineStatistics();
+        ImGui::Text(std::format("Position Ring: {} slots, {:.1f}% of steps overlapped, {:.3f} ms average stall, {:.2f} frames in flight",
+                                pipeline.ringDepth, pipeline.GetOverlapRatio() * 100.0, pipeline.GetAverageStallSeconds() * 1000.0,
+                                pipeline.GetAverageFramesInFlight())
+                        .c_str());
+      }
       std::pair<int, int> currentRes = Settings::RESOLUTIONS[currentResolution];
       if (ImGui::BeginCombo("Resolution", std::format("{}x{}", currentRes.first, currentRes.second).c_str()))
       {
@@ -227,6 +406,25 @@ namespace PLPP
         Settings::setDisplayMode(window, Settings::DISPLAY_MODES[currentDisplayMode]);
       }
 
+      // Each primitive's draw time shows up under its shader's name in the profiler
+      const char *particlePrimitives[] = {"Quads", "Points", "Pixels"};
+      std::string currentPrimitive = particlePrimitiveAuto ? std::format("Auto ({})", particlePrimitives[static_cast<int>(particlePrimitive)])
+                                                           : particlePrimitives[static_cast<int>(particlePrimitive)];
+      if (ImGui::BeginCombo("Particle Rendering", currentPrimitive.c_str()))
+      {
+        if (ImGui::Selectable("Auto", particlePrimitiveAuto))
+          particlePrimitiveAuto = true;
+        for (int i = 0; i < 3; i++)
+        {
+          if (ImGui::Selectable(particlePrimitives[i], !particlePrimitiveAuto && static_cast<int>(particlePrimitive) == i))
+          {
+            particlePrimitiveAuto = false;
+            particlePrimitive = static_cast<ParticlePrimitive>(i);
+          }
+        }
+        ImGui::EndCombo();
+      }
+
       static bool vsync;
       ImGui::Checkbox("VSync Enabled", &vsync);
       if (vsync && !Settings::vsync)
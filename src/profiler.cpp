@@ -0,0 +1,219 @@
+#include "plpp/profiler.h"
+
+// Project Includes
+#include "plpp/constants.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace PLPP
+{
+  namespace
+  {
+    struct PhaseHistory
+    {
+      const char *name;
+      std::array<double, PROFILER_HISTORY_FRAMES> samples{};
+      int next = 0;
+      int count = 0;
+      // Frames in a row the phase did not show up in, it is dropped after a full history
+      int idleFrames = 0;
+    };
+
+    std::mutex mutex;
+    std::vector<ProfileEvent> frameEvents;
+    // Keyed on the name's text, the same literal may live at several addresses
+    std::map<std::pair<std::string_view, bool>, PhaseHistory> phases;
+    std::set<std::string, std::less<>> internedNames;
+
+    int captureFramesLeft = 0;
+    std::vector<ProfileEvent> captureEvents;
+    std::filesystem::path capturePath;
+    std::filesystem::path lastTrace;
+
+    thread_local int scopeDepth = 0;
+
+    std::string escapeJson(std::string_view value)
+    {
+      std::string escaped;
+      for (char c : value)
+      {
+        if (c == '"' || c == '\\')
+          escaped += '\\';
+        escaped += c;
+      }
+      return escaped;
+    }
+  }
+
+  std::atomic<bool> Profiler::Enabled = false;
+  const std::chrono::steady_clock::time_point Profiler::epoch_ = std::chrono::steady_clock::now();
+
+  void Profiler::Record(const ProfileEvent &event)
+  {
+    std::lock_guard lock(mutex);
+    frameEvents.push_back(event);
+  }
+
+  int Profiler::GetThreadId()
+  {
+    static std::atomic<int> nextId = 0;
+    thread_local int id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+  }
+
+  const char *Profiler::Intern(std::string_view name)
+  {
+    std::lock_guard lock(mutex);
+    auto interned = internedNames.find(name);
+    if (interned == internedNames.end())
+      interned = internedNames.emplace(name).first;
+    return interned->c_str();
+  }
+
+  void Profiler::EndFrame()
+  {
+    std::vector<ProfileEvent> traceEvents;
+    std::filesystem::path tracePath;
+    {
+      std::lock_guard lock(mutex);
+      std::map<std::pair<std::string_view, bool>, double> totals;
+      for (const ProfileEvent &event : frameEvents)
+      {
+        totals[{event.name, event.gpu}] += event.duration;
+        phases.try_emplace({event.name, event.gpu}).first->second.name = event.name;
+      }
+
+      for (auto phase = phases.begin(); phase != phases.end();)
+      {
+        PhaseHistory &history = phase->second;
+        auto total = totals.find(phase->first);
+        history.idleFrames = total == totals.end() ? history.idleFrames + 1 : 0;
+        if (history.idleFrames >= PROFILER_HISTORY_FRAMES)
+        {
+          phase = phases.erase(phase);
+          continue;
+        }
+        history.samples[history.next] = total == totals.end() ? 0.0 : total->second;
+        history.next = (history.next + 1) % PROFILER_HISTORY_FRAMES;
+        history.count = std::min(history.count + 1, PROFILER_HISTORY_FRAMES);
+        ++phase;
+      }
+
+      if (captureFramesLeft > 0)
+      {
+        captureEvents.insert(captureEvents.end(), frameEvents.begin(), frameEvents.end());
+        if (--captureFramesLeft == 0)
+        {
+          traceEvents.swap(captureEvents);
+          tracePath = capturePath;
+        }
+      }
+      frameEvents.clear();
+    }
+
+    // Written outside the lock, the other threads keep recording meanwhile
+    if (!tracePath.empty() && writeTrace(tracePath, traceEvents))
+    {
+      std::lock_guard lock(mutex);
+      lastTrace = tracePath;
+    }
+  }
+
+  std::vector<PhaseStatistics> Profiler::GetPhases()
+  {
+    std::lock_guard lock(mutex);
+    std::vector<PhaseStatistics> statistics;
+    for (const auto &[key, history] : phases)
+    {
+      PhaseStatistics phase{history.name, key.second, 0.0, 0.0, 0.0};
+      if (history.count > 0)
+      {
+        double sum = 0.0;
+        for (int i = 0; i < history.count; i++)
+        {
+          sum += history.samples[i];
+          phase.maximumSeconds = std::max(phase.maximumSeconds, history.samples[i]);
+        }
+        phase.averageSeconds = sum / history.count;
+        phase.lastSeconds = history.samples[(history.next + PROFILER_HISTORY_FRAMES - 1) % PROFILER_HISTORY_FRAMES];
+      }
+      statistics.push_back(phase);
+    }
+    return statistics;
+  }
+
+  void Profiler::CaptureTrace(int frameCount, std::filesystem::path path)
+  {
+    std::lock_guard lock(mutex);
+    captureEvents.clear();
+    captureFramesLeft = std::max(frameCount, 1);
+    capturePath = std::move(path);
+  }
+
+  bool Profiler::IsCapturing()
+  {
+    std::lock_guard lock(mutex);
+    return captureFramesLeft > 0;
+  }
+
+  std::filesystem::path Profiler::GetLastTrace()
+  {
+    std::lock_guard lock(mutex);
+    return lastTrace;
+  }
+
+  bool Profiler::writeTrace(const std::filesystem::path &path, const std::vector<ProfileEvent> &events)
+  {
+    std::ofstream trace(path);
+    // Complete events, GPU scopes get a track of their own placed where the CPU issued them
+    trace << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    trace << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1000, \"args\": {\"name\": \"GPU\"}}";
+    for (const ProfileEvent &event : events)
+    {
+      trace << std::format(",\n{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": 1, \"tid\": {}}}",
+                           escapeJson(event.name), event.gpu ? "gpu" : "cpu", event.start * 1e6, event.duration * 1e6,
+                           event.gpu ? 1000 : event.threadId);
+    }
+    trace << "\n]}\n";
+
+    if (!trace)
+    {
+      std::cerr << std::format("ERROR::PROFILER: Failed to write trace '{}'", path.string()) << std::endl;
+      return false;
+    }
+    std::cout << std::format("Profiler trace written to {}", path.string()) << std::endl;
+    return true;
+  }
+
+  ProfileScope::ProfileScope(const char *name)
+      : name_(name), active_(Profiler::Enabled.load(std::memory_order_relaxed))
+  {
+    if (!active_)
+      return;
+    depth_ = scopeDepth++;
+    start_ = Profiler::GetSeconds();
+  }
+
+  ProfileScope::~ProfileScope()
+  {
+    if (!active_)
+      return;
+    scopeDepth--;
+    Profiler::Record({name_, start_, Profiler::GetSeconds() - start_, Profiler::GetThreadId(), depth_, false});
+  }
+}
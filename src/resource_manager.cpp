@@ -1,27 +1,122 @@
 #include "plpp/resource_manager.h"
 
+// Project Includes
+#include "plpp/profiler.h"
+
 // External Libraries
 #include <glad/glad.h>
+#include <glfw/glfw3.h>
 
 // C++ Standard Library
+#include <algorithm>
+#include <cstring>
+#include <format>
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <fstream>
 
 namespace PLPP
 { // Instantiate static variables
   std::map<std::string, Shader> ResourceManager::Shaders;
+  std::filesystem::path ResourceManager::ProgramCacheDirectory = "shader_cache";
+  std::vector<ResourceManager::PendingBinary> ResourceManager::pendingBinaries_;
+
+  namespace
+  {
+    // glad is generated for the core profile only, the extension entry point is fetched by hand
+    typedef void(APIENTRY *MaxShaderCompilerThreadsProc)(GLuint count);
+
+    // Lets the driver compile on its own threads when it supports KHR_parallel_shader_compile
+    void enableParallelShaderCompile()
+    {
+      static bool enabled = false;
+      if (enabled)
+        return;
+      enabled = true;
+
+      GLint extensionCount = 0;
+      glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+      for (GLint i = 0; i < extensionCount; i++)
+      {
+        const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+        {
+          auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+          if (maxShaderCompilerThreads)
+            maxShaderCompilerThreads(0xFFFFFFFFu);
+          return;
+        }
+      }
+    }
+
+    uint64_t fnv1a(uint64_t hash, const char *data, size_t size)
+    {
+      for (size_t i = 0; i < size; i++)
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+      return hash;
+    }
+
+    // Replaces #include "file" lines with the file, looked up next to the including one. GLSL has
+    // no includes of its own, the force kernels share particles_common.glsl this way.
+    std::string expandIncludes(const std::string &code, const std::filesystem::path &directory, int depth = 0)
+    {
+      std::istringstream lines(code);
+      std::string line, expanded;
+      while (std::getline(lines, line))
+      {
+        size_t open = line.find('"'), close = line.rfind('"');
+        if (line.starts_with("#include") && open != std::string::npos && close > open)
+        {
+          std::filesystem::path includePath = directory / line.substr(open + 1, close - open - 1);
+          std::ifstream includeFile(includePath);
+          if (includeFile && depth < 8)
+          {
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            expanded += expandIncludes(includeStream.str(), includePath.parent_path(), depth + 1);
+            continue;
+          }
+          // Left in place, the compiler then reports the line
+          std::cout << std::format("ERROR::SHADER: Failed to include '{}'", includePath.string()) << std::endl;
+        }
+        expanded += line;
+        expanded += '\n';
+      }
+      return expanded;
+    }
+
+    // #version has to stay the first statement
+    void insertDefines(std::string &code, const ShaderDefines &defines)
+    {
+      std::string defineLines;
+      for (const auto &[define, value] : defines)
+        defineLines += std::format("#define {} {}\n", define, value);
+      size_t versionEnd = code.find('\n');
+      code.insert(versionEnd == std::string::npos ? code.size() : versionEnd + 1, defineLines);
+    }
+  }
+
+  Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name, const ShaderDefines &defines)
+  {
+    Shader shader = loadShaderFromFile(vShaderFile, fShaderFile, name, defines);
+    shader.Name = Profiler::Intern(name);
+    Shaders.emplace(name, shader);
+    return shader;
+  }
 
-  Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, std::string name)
+  Shader ResourceManager::LoadShader(const char *cShaderFile, std::string name, const ShaderDefines &defines)
   {
-    Shader shader = loadShaderFromFile(vShaderFile, fShaderFile);
+    Shader shader = loadShaderFromFile(cShaderFile, name, defines, false);
+    shader.Name = Profiler::Intern(name);
     Shaders.emplace(name, shader);
     return shader;
   }
 
-  Shader ResourceManager::LoadShader(const char *cShaderFile, std::string name)
+  Shader ResourceManager::LoadDeferredShader(const char *cShaderFile, std::string name, const ShaderDefines &defines)
   {
-    Shader shader = loadShaderFromFile(cShaderFile);
+    Shader shader = loadShaderFromFile(cShaderFile, name, defines, true);
+    shader.Name = Profiler::Intern(name);
     Shaders.emplace(name, shader);
     return shader;
   }
@@ -32,7 +127,14 @@ namespace PLPP
       glDeleteProgram(iter.second.ID);
   }
 
-  Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile)
+  void ResourceManager::StoreProgramBinaries()
+  {
+    for (const PendingBinary &pending : pendingBinaries_)
+      storeProgramBinary(pending.path, pending.program);
+    pendingBinaries_.clear();
+  }
+
+  Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const std::string &name, const ShaderDefines &defines)
   {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -57,13 +159,23 @@ namespace PLPP
     {
       std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
     }
+    vertexCode = expandIncludes(vertexCode, std::filesystem::path(vShaderFile).parent_path());
+    fragmentCode = expandIncludes(fragmentCode, std::filesystem::path(fShaderFile).parent_path());
+    insertDefines(vertexCode, defines);
+    insertDefines(fragmentCode, defines);
+    std::filesystem::path binaryPath = programBinaryPath(name, {&vertexCode, &fragmentCode});
+    if (unsigned int program = loadProgramBinary(binaryPath))
+      return Shader::FromProgram(program, true);
+
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
 
-    return Shader(vShaderCode, fShaderCode);
+    Shader shader(vShaderCode, fShaderCode);
+    storeProgramBinary(binaryPath, shader.ID);
+    return shader;
   }
 
-  Shader ResourceManager::loadShaderFromFile(const char *cShaderFile)
+  Shader ResourceManager::loadShaderFromFile(const char *cShaderFile, const std::string &name, const ShaderDefines &defines, bool deferred)
   {
     std::string computeCode;
     try
@@ -78,7 +190,91 @@ namespace PLPP
     {
       std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
     }
+    computeCode = expandIncludes(computeCode, std::filesystem::path(cShaderFile).parent_path());
+    insertDefines(computeCode, defines);
+
+    std::filesystem::path binaryPath = programBinaryPath(name, {&computeCode});
+    if (unsigned int program = loadProgramBinary(binaryPath))
+      return Shader::FromProgram(program, false);
+
+    enableParallelShaderCompile();
     const char *cShaderCode = computeCode.c_str();
-    return Shader(cShaderCode);
+    Shader shader(cShaderCode, deferred);
+    // Retrieving the binary would wait for the link, deferred programs are stored later
+    if (deferred)
+    {
+      bool pending = std::any_of(pendingBinaries_.begin(), pendingBinaries_.end(), [&](const PendingBinary &other)
+                                 { return other.path == binaryPath; });
+      if (!binaryPath.empty() && !pending)
+        pendingBinaries_.push_back({binaryPath, shader.ID});
+    }
+    else
+      storeProgramBinary(binaryPath, shader.ID);
+    return shader;
+  }
+
+  std::filesystem::path ResourceManager::programBinaryPath(const std::string &name, std::initializer_list<const std::string *> sources)
+  {
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (ProgramCacheDirectory.empty() || formatCount <= 0)
+      return {};
+
+    // Binaries are only valid for the driver that produced them. The sources already carry any
+    // variant defines, so each variant gets its own entry.
+    uint64_t key = 14695981039346656037ull;
+    for (GLenum property : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+      const char *value = reinterpret_cast<const char *>(glGetString(property));
+      if (value)
+        key = fnv1a(key, value, std::strlen(value) + 1);
+    }
+    for (const std::string *source : sources)
+      key = fnv1a(key, source->c_str(), source->size() + 1);
+    return ProgramCacheDirectory / std::format("{}-{:016x}.bin", name, key);
+  }
+
+  unsigned int ResourceManager::loadProgramBinary(const std::filesystem::path &path)
+  {
+    if (path.empty())
+      return 0;
+    std::ifstream file(path, std::ios::binary);
+    GLenum format;
+    if (!file.read(reinterpret_cast<char *>(&format), sizeof(format)))
+      return 0;
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success)
+      return program;
+
+    // A driver update can invalidate binaries without changing the version string
+    std::cout << std::format("Program binary {} was rejected, compiling from source", path.string()) << std::endl;
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  void ResourceManager::storeProgramBinary(const std::filesystem::path &path, unsigned int program)
+  {
+    GLint success = 0, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (path.empty() || !success || length <= 0)
+      return;
+
+    GLenum format;
+    std::vector<char> binary(length);
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    if (!file)
+      std::cerr << std::format("Failed to write program binary {}\n", path.string());
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,66 @@
+#include "plpp/scaling_report.h"
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <ostream>
+#include <vector>
+
+namespace PLPP
+{
+  std::vector<ScalingSample> ScalingReport::Measure(CPUPhysicsEngine &engine, glm::ivec2 display, float deltaTime, int steps, const std::vector<int> &threadCounts)
+  {
+    std::vector<glm::vec2> positions, velocities;
+    std::vector<int> types;
+    engine.ReadParticles(positions, velocities, types);
+
+    std::vector<ScalingSample> samples;
+    for (int threadCount : threadCounts)
+    {
+      // Every run starts from the same state so the work per step is identical
+      CPUPhysicsEngine trial(threadCount);
+      trial.CopyParameters(engine);
+      trial.taskGrainSize = engine.taskGrainSize;
+      trial.AddParticles(types, positions, velocities);
+
+      trial.Update(deltaTime, display);
+      uint64_t stealsBefore = trial.GetThreadPool().GetStealCount();
+      auto start = std::chrono::steady_clock::now();
+      for (int step = 0; step < steps; step++)
+        trial.Update(deltaTime, display);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      ScalingSample sample;
+      sample.threadCount = trial.GetThreadCount();
+      sample.secondsPerStep = elapsed.count() / std::max(1, steps);
+      sample.speedup = samples.empty() ? 1.0 : samples.front().secondsPerStep / sample.secondsPerStep;
+      sample.efficiency = sample.speedup * (samples.empty() ? sample.threadCount : samples.front().threadCount) / sample.threadCount;
+      sample.steals = trial.GetThreadPool().GetStealCount() - stealsBefore;
+      samples.push_back(sample);
+    }
+    return samples;
+  }
+
+  std::vector<int> ScalingReport::PowersOfTwo(int maxThreads)
+  {
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+      threadCounts.push_back(threads);
+    threadCounts.push_back(std::max(1, maxThreads));
+    return threadCounts;
+  }
+
+  void ScalingReport::Print(std::ostream &out, const std::vector<ScalingSample> &samples)
+  {
+    out << "threads  ms/step  speedup  efficiency  steals\n";
+    for (const ScalingSample &sample : samples)
+    {
+      out << std::format("{:>7}  {:>7.3f}  {:>7.2f}  {:>9.1f}%  {:>6}\n",
+                         sample.threadCount, sample.secondsPerStep * 1000.0, sample.speedup, sample.efficiency * 100.0, sample.steals);
+    }
+  }
+}
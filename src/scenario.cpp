@@ -0,0 +1,165 @@
+#include "plpp/scenario.h"
+
+// Project Includes
+#include "plpp/constants.h"
+
+// C++ Standard Library
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace PLPP
+{
+  namespace
+  {
+    std::string trim(const std::string &value)
+    {
+      size_t begin = value.find_first_not_of(" \t\r");
+      size_t end = value.find_last_not_of(" \t\r");
+      return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+    }
+  }
+
+  int Scenario::GetParticleCount() const
+  {
+    return std::accumulate(particlesPerType.begin(), particlesPerType.end(), 0);
+  }
+
+  bool Scenario::Load(const std::string &path, Scenario &scenario)
+  {
+    std::ifstream file(path);
+    if (!file)
+    {
+      std::cerr << std::format("ERROR::SCENARIO: Failed to open '{}'", path) << std::endl;
+      return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+      lineNumber++;
+      line = trim(line.substr(0, line.find('#')));
+      if (line.empty())
+        continue;
+
+      size_t separator = line.find('=');
+      if (separator == std::string::npos)
+      {
+        std::cerr << std::format("ERROR::SCENARIO: {}:{} expected 'key = value'", path, lineNumber) << std::endl;
+        return false;
+      }
+      std::istringstream key(trim(line.substr(0, separator)));
+      std::istringstream value(trim(line.substr(separator + 1)));
+      std::string name;
+      key >> name;
+
+      bool valid = true;
+      if (name == "width")
+        valid = static_cast<bool>(value >> scenario.display.x);
+      else if (name == "height")
+        valid = static_cast<bool>(value >> scenario.display.y);
+      else if (name == "friction")
+        valid = static_cast<bool>(value >> scenario.friction);
+      else if (name == "particleRadius")
+        valid = static_cast<bool>(value >> scenario.particleRadius);
+      else if (name == "forceMultiplier")
+        valid = static_cast<bool>(value >> scenario.forceMultiplier);
+      else if (name == "effectiveForceRadius")
+        valid = static_cast<bool>(value >> scenario.effectiveForceRadius);
+      else if (name == "spatialGrid")
+        valid = static_cast<bool>(value >> scenario.useSpatialGrid);
+      else if (name == "randomForces")
+        valid = static_cast<bool>(value >> scenario.randomForces);
+      else if (name == "particles")
+      {
+        scenario.particlesPerType.clear();
+        int count;
+        while (valid && value >> count)
+        {
+          valid = count >= 0;
+          scenario.particlesPerType.push_back(count);
+        }
+        valid = valid && !scenario.particlesPerType.empty() && scenario.GetTypeCount() <= MAXIMUM_PARTICLE_TYPES;
+      }
+      else if (name == "forces")
+      {
+        int row = -1;
+        key >> row;
+        valid = row >= 0 && row < MAXIMUM_PARTICLE_TYPES;
+        float force;
+        for (int column = 0; valid && value >> force; column++)
+        {
+          valid = column < MAXIMUM_PARTICLE_TYPES;
+          if (valid)
+            scenario.forceMatrix[row * MAXIMUM_PARTICLE_TYPES + column] = force;
+        }
+      }
+      else
+      {
+        std::cerr << std::format("ERROR::SCENARIO: {}:{} unknown key '{}'", path, lineNumber, name) << std::endl;
+        return false;
+      }
+
+      if (!valid)
+      {
+        std::cerr << std::format("ERROR::SCENARIO: {}:{} invalid value for '{}'", path, lineNumber, name) << std::endl;
+        return false;
+      }
+    }
+
+    if (scenario.particlesPerType.empty())
+    {
+      std::cerr << std::format("ERROR::SCENARIO: '{}' does not define any particles", path) << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  void Scenario::Apply(PhysicsEngine &engine, uint64_t seed)
+  {
+    if (randomForces)
+    {
+      std::mt19937_64 rng(seed ^ 0x9E3779B97F4A7C15ull);
+      std::uniform_real_distribution<float> force(-1.0f, 1.0f);
+      for (int row = 0; row < GetTypeCount(); row++)
+      {
+        for (int column = 0; column < GetTypeCount(); column++)
+          forceMatrix[row * MAXIMUM_PARTICLE_TYPES + column] = force(rng);
+      }
+    }
+
+    engine.friction = friction;
+    engine.particleRadius = particleRadius;
+    engine.forceMultiplier = forceMultiplier;
+    engine.effectiveForceRadius = effectiveForceRadius;
+    engine.useSpatialGrid = useSpatialGrid;
+    std::copy(forceMatrix.begin(), forceMatrix.end(), engine.GetForcesBuffer());
+  }
+
+  void Scenario::Spawn(PhysicsEngine &engine, uint64_t seed) const
+  {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<float> x(0.0f, static_cast<float>(display.x));
+    std::uniform_real_distribution<float> y(0.0f, static_cast<float>(display.y));
+    std::vector<int> types;
+    std::vector<glm::vec2> positions;
+    types.reserve(GetParticleCount());
+    positions.reserve(GetParticleCount());
+    for (int type = 0; type < GetTypeCount(); type++)
+    {
+      for (int i = 0; i < particlesPerType[type]; i++)
+      {
+        types.push_back(type);
+        // Draw x before y, argument evaluation order is unspecified
+        float px = x(rng);
+        positions.emplace_back(px, y(rng));
+      }
+    }
+    engine.AddParticles(types, positions);
+  }
+}
@@ -1,11 +1,15 @@
 #include "plpp/shader.h"
 
+// Project Includes
+#include "plpp/gpu_profiler.h"
+
 // External Libraries
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
 #include <glm/glm.hpp>
 
 // C++ Standard Library
+#include <algorithm>
 #include <format>
 #include <iostream>
 #include <vector>
@@ -29,35 +33,52 @@ namespace PLPP
     this->ID = glCreateProgram();
     glAttachShader(this->ID, sVertex);
     glAttachShader(this->ID, sFragment);
-    
+    // Lets ResourceManager store the linked program in its binary cache
+    glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
-    
+    cacheUniformLocations();
+
     initRenderData();
     type_ = ShaderType::Render;
   }
 
-  Shader::Shader(const char *computeSource)
+  Shader::Shader(const char *computeSource, bool deferLink)
   {
     unsigned int sCompute;
     sCompute = glCreateShader(GL_COMPUTE_SHADER);
     glShaderSource(sCompute, 1, &computeSource, NULL);
     glCompileShader(sCompute);
-    checkCompileErrors(sCompute, "COMPUTE");
     this->ID = glCreateProgram();
     glAttachShader(this->ID, sCompute);
+    glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(this->ID);
-    checkCompileErrors(this->ID, "PROGRAM");
-    glDeleteShader(sCompute);
 
     type_ = ShaderType::Compute;
+    // Querying any status would wait for the compiler, leave that to the first use
+    linkPending_ = true;
+    if (!deferLink)
+      finishLink();
+  }
+
+  Shader Shader::FromProgram(unsigned int program, bool renderProgram)
+  {
+    Shader shader;
+    shader.ID = program;
+    shader.type_ = renderProgram ? ShaderType::Render : ShaderType::Compute;
+    shader.cacheUniformLocations();
+    if (renderProgram)
+      shader.initRenderData();
+    return shader;
   }
 
   Shader &Shader::Use()
   {
+    if (linkPending_)
+      finishLink();
     glUseProgram(this->ID);
     return *this;
   }
@@ -65,21 +86,27 @@ namespace PLPP
   void Shader::Render(
       GLFWwindow *window,
       const unsigned int positions,
+      const unsigned int previousPositions,
+      const unsigned int types,
+      const unsigned int palette,
       const float radius,
-      const std::vector<glm::vec4> colors,
-      const int particleCount)
+      const float alpha,
+      const int particleCount,
+      ParticlePrimitive primitive)
   {
     if (type_ != ShaderType::Render)
     {
       std::cerr << "ERROR::SHADER::RENDER: Attempting to render a shader of invalid type!" << std::endl;
       return;
     }
+    PLPP_PROFILE_GPU_SCOPE(Name);
     // Use the shader program
     Use();
 
-    glBindBuffer(GL_ARRAY_BUFFER, colorInstanceVBO_);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec4), colors.data(), GL_DYNAMIC_DRAW);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positions);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, previousPositions);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, types);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, palette);
 
     int displayWidth, displayHeight;
     glfwGetFramebufferSize(window, &displayWidth, &displayHeight);
@@ -89,11 +116,19 @@ namespace PLPP
     SetMat4("projection", projection);
 
     SetFloat("radius", radius);
+    SetFloat("alpha", alpha);
 
-    // Bind the VAO and draw the quad
-    glBindVertexArray(quadVAO_);
-    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, particleCount);
-    // Unbind the VAO
+    glBindVertexArray(emptyVAO_);
+    if (primitive == ParticlePrimitive::Quads)
+    {
+      glDrawArrays(GL_TRIANGLES, 0, 6 * particleCount);
+    }
+    else
+    {
+      // The vertex shader sets the point size
+      glEnable(GL_PROGRAM_POINT_SIZE);
+      glDrawArrays(GL_POINTS, 0, particleCount);
+    }
     glBindVertexArray(0);
   }
 
@@ -105,100 +140,119 @@ namespace PLPP
       std::cerr << "ERROR::SHADER::COMPUTE: Attempting to render a shader of invalid type!" << std::endl;
       return;
     }
+      PLPP_PROFILE_GPU_SCOPE(Name);
       glDispatchCompute(groups, 1, 1);
       glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
   }
 
+  GLint Shader::GetUniformLocation(std::string_view name) const
+  {
+    auto location = uniformLocations_.find(name);
+    return location != uniformLocations_.end() ? location->second : -1;
+  }
+
   void Shader::SetFloat(const char *name, float value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    glUniform1f(GetUniformLocation(name), value);
   }
   void Shader::SetInteger(const char *name, int value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    glUniform1i(GetUniformLocation(name), value);
+  }
+  void Shader::SetUnsigned(const char *name, unsigned int value, bool useShader)
+  {
+    if (useShader)
+      this->Use();
+    glUniform1ui(GetUniformLocation(name), value);
+  }
+  void Shader::SetFloats(const char *name, const float *values, int count, bool useShader)
+  {
+    if (useShader)
+      this->Use();
+    glUniform1fv(GetUniformLocation(name), count, values);
   }
   void Shader::SetVec2f(const char *name, float x, float y, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    glUniform2f(GetUniformLocation(name), x, y);
   }
   void Shader::SetVec2f(const char *name, const glm::vec2 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform2f(GetUniformLocation(name), value.x, value.y);
   }
   void Shader::SetVec3f(const char *name, float x, float y, float z, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform3f(GetUniformLocation(name), x, y, z);
   }
   void Shader::SetVec3f(const char *name, const glm::vec3 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
   }
   void Shader::SetVec4f(const char *name, float x, float y, float z, float w, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform4f(GetUniformLocation(name), x, y, z, w);
   }
   void Shader::SetVec4f(const char *name, const glm::vec4 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
   }
   void Shader::SetVec2i(const char *name, int x, int y, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform2i(glGetUniformLocation(this->ID, name), x, y);
+    glUniform2i(GetUniformLocation(name), x, y);
   }
   void Shader::SetVec2i(const char *name, const glm::ivec2 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform2i(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform2i(GetUniformLocation(name), value.x, value.y);
   }
   void Shader::SetVec3i(const char *name, int x, int y, int z, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform3i(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform3i(GetUniformLocation(name), x, y, z);
   }
   void Shader::SetVec3i(const char *name, const glm::ivec3 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform3i(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform3i(GetUniformLocation(name), value.x, value.y, value.z);
   }
   void Shader::SetVec4i(const char *name, int x, int y, int z, int w, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform4i(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform4i(GetUniformLocation(name), x, y, z, w);
   }
   void Shader::SetVec4i(const char *name, const glm::ivec4 &value, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniform4i(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4i(GetUniformLocation(name), value.x, value.y, value.z, value.w);
   }
   void Shader::SetMat4(const char *name, const glm::mat4 &matrix, bool useShader)
   {
     if (useShader)
       this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, GL_FALSE, glm::value_ptr(matrix));
+    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(matrix));
   }
 
   void Shader::checkCompileErrors(unsigned int object, std::string type)
@@ -225,51 +279,49 @@ namespace PLPP
     }
   }
 
-  void Shader::initRenderData()
+  void Shader::finishLink()
   {
-    unsigned int VBO;
-    float vertices[] = {
-        // x, y
-        -1.0f, 1.0f,
-        1.0f, -1.0f,
-        -1.0f, -1.0f,
-        1.0f, 1.0f};
-
-    unsigned int EBO;
-    unsigned int indices[] = {
-        0, 1, 2,
-        0, 1, 3};
-
-    // Instantiate Vertex Array Object (VAO) and Vertex Buffer Object (VBO)
-    glGenVertexArrays(1, &quadVAO_);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glGenBuffers(1, &positionInstanceVBO_);
-    glGenBuffers(1, &colorInstanceVBO_);
-
-    // Bind VAO and set vertex attribute pointers
-    glBindVertexArray(quadVAO_);
-
-    // Bind VBO and copy vertex data to it
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Bind EBO and copy index data to it
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Define vertex attribute structure
-    // (position 0, 2 floats per vertex, no normalization, stride of 2 floats, offset 0)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
+    // Copies of a deferred shader each finish on their first use, only the first still finds the shaders attached
+    GLuint shaders[2];
+    GLsizei shaderCount = 0;
+    glGetAttachedShaders(this->ID, 2, &shaderCount, shaders);
+    for (GLsizei i = 0; i < shaderCount; i++)
+    {
+      checkCompileErrors(shaders[i], "COMPUTE");
+      glDetachShader(this->ID, shaders[i]);
+      glDeleteShader(shaders[i]);
+    }
+    checkCompileErrors(this->ID, "PROGRAM");
+    cacheUniformLocations();
+    linkPending_ = false;
+  }
 
-    glBindBuffer(GL_ARRAY_BUFFER, colorInstanceVBO_);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribDivisor(1, 1);
+  void Shader::cacheUniformLocations()
+  {
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+      GLsizei nameLength;
+      GLint size;
+      GLenum type;
+      glGetActiveUniform(this->ID, i, static_cast<GLsizei>(nameBuffer.size()), &nameLength, &size, &type, nameBuffer.data());
+      std::string name(nameBuffer.data(), nameLength);
+      // Members of uniform blocks have no location, they are set through the block's buffer
+      GLint location = glGetUniformLocation(this->ID, name.c_str());
+      if (location < 0)
+        continue;
+      if (name.ends_with("[0]"))
+        uniformLocations_.emplace(name.substr(0, name.size() - 3), location);
+      uniformLocations_.emplace(std::move(name), location);
+    }
+  }
 
-    // Unbind the VAO (rebind when rendering)
-    glBindVertexArray(0);
+  void Shader::initRenderData()
+  {
+    glGenVertexArrays(1, &emptyVAO_);
   }
 
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "plpp/simulation_thread.h"
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/fixed_timestep.h"
+#include "plpp/physics_engine.h"
+#include "plpp/profiler.h"
+#include "plpp/snapshot.h"
+#include "plpp/trajectory_recorder.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace PLPP
+{
+  SimulationThread::SimulationThread(int threadCount)
+      : threadCount_(threadCount), parameters_(1)
+  {
+  }
+
+  void SimulationThread::Start(PhysicsEngine &source)
+  {
+    if (IsRunning())
+      return;
+
+    // The pool is only built once the thread is first used
+    if (!engine_)
+      engine_ = std::make_unique<CPUPhysicsEngine>(threadCount_);
+    engine_->ClearParticles();
+    engine_->CopyParameters(source);
+
+    std::vector<glm::vec2> positions, velocities;
+    std::vector<int> types;
+    source.ReadParticles(positions, velocities, types);
+    engine_->AddParticles(types, positions, velocities);
+    lastPositions_.clear();
+
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread(&SimulationThread::run, this);
+  }
+
+  void SimulationThread::Stop()
+  {
+    if (!IsRunning())
+      return;
+    stopping_.store(true, std::memory_order_release);
+    thread_.join();
+
+    // Changes queued after the last step still belong to the final state
+    std::lock_guard lock(commandMutex_);
+    for (auto &command : commands_)
+      command(*engine_);
+    commands_.clear();
+    if (parametersChanged_)
+      engine_->CopyParameters(parameters_);
+    parametersChanged_ = false;
+  }
+
+  void SimulationThread::SetParameters(PhysicsEngine &source)
+  {
+    std::lock_guard lock(commandMutex_);
+    parameters_.CopyParameters(source);
+    parametersChanged_ = true;
+  }
+
+  void SimulationThread::SetTimestep(const FixedTimestep &timestep)
+  {
+    std::lock_guard lock(commandMutex_);
+    timestep_.stepsPerSecond = timestep.stepsPerSecond;
+    timestep_.maxSubsteps = timestep.maxSubsteps;
+  }
+
+  void SimulationThread::SetDisplay(glm::ivec2 display)
+  {
+    std::lock_guard lock(commandMutex_);
+    display_ = display;
+  }
+
+  void SimulationThread::SetPaused(bool paused)
+  {
+    std::lock_guard lock(commandMutex_);
+    paused_ = paused;
+  }
+
+  void SimulationThread::AddParticles(std::span<const int> typeIds, std::span<const glm::vec2> positions)
+  {
+    std::lock_guard lock(commandMutex_);
+    commands_.push_back([types = std::vector<int>(typeIds.begin(), typeIds.end()), positions = std::vector<glm::vec2>(positions.begin(), positions.end())](CPUPhysicsEngine &engine)
+                        { engine.AddParticles(types, positions); });
+  }
+
+  void SimulationThread::SpawnParticles(const SpawnDistribution &distribution, glm::ivec2 display)
+  {
+    std::lock_guard lock(commandMutex_);
+    commands_.push_back([distribution, display](CPUPhysicsEngine &engine)
+                        { engine.SpawnParticles(distribution, display); });
+  }
+
+  void SimulationThread::SaveSnapshot(const std::filesystem::path &path, glm::ivec2 display)
+  {
+    std::lock_guard lock(commandMutex_);
+    commands_.push_back([path, display](CPUPhysicsEngine &engine)
+                        { Snapshot::Save(path, engine, display); });
+  }
+
+  void SimulationThread::SetRecorder(TrajectoryRecorder *recorder, int interval)
+  {
+    std::lock_guard lock(recorderMutex_);
+    recorder_ = recorder;
+    recordInterval_ = std::max(interval, 1);
+  }
+
+  void SimulationThread::run()
+  {
+    FixedTimestep timestep;
+    std::vector<std::function<void(CPUPhysicsEngine &)>> commands;
+    auto lastTime = std::chrono::steady_clock::now();
+    // The first frame shows the particles handed over by Start
+    bool changed = true;
+
+    while (!stopping_.load(std::memory_order_acquire))
+    {
+      bool paused;
+      glm::ivec2 display;
+      {
+        std::lock_guard lock(commandMutex_);
+        if (parametersChanged_)
+          engine_->CopyParameters(parameters_);
+        parametersChanged_ = false;
+        timestep.stepsPerSecond = timestep_.stepsPerSecond;
+        timestep.maxSubsteps = timestep_.maxSubsteps;
+        commands.swap(commands_);
+        paused = paused_;
+        display = display_;
+      }
+      for (auto &command : commands)
+        command(*engine_);
+      changed = changed || !commands.empty();
+      commands.clear();
+
+      auto now = std::chrono::steady_clock::now();
+      int steps = paused ? 0 : timestep.Advance(std::chrono::duration<double>(now - lastTime).count());
+      lastTime = now;
+      for (int step = 0; step < steps; step++)
+      {
+        PLPP_PROFILE_SCOPE("Simulation Step");
+        engine_->Update(timestep.GetStepSeconds(), display);
+        publish(timestep.GetStepSeconds(), display);
+      }
+      // Particles added while paused still have to show up
+      if (steps == 0 && changed)
+        publish(0.0f, display);
+      changed = false;
+      stepRate_.Tick(steps);
+
+      // Sleep until the next step is due, a paused simulation only polls for changes
+      double waitSeconds = paused ? 0.005 : (1.0 - timestep.GetAlpha()) * timestep.GetStepSeconds();
+      std::this_thread::sleep_for(std::chrono::duration<double>(waitSeconds));
+    }
+  }
+
+  void SimulationThread::publish(float stepSeconds, glm::ivec2 display)
+  {
+    PLPP_PROFILE_SCOPE("Publish Frame");
+    SimulationFrame &frame = frames_.GetWriteBuffer();
+    engine_->ReadParticles(frame.positions, velocities_, frame.types);
+
+    // Particles added since the last frame have no previous position, they start where they are
+    frame.previousPositions = lastPositions_;
+    frame.previousPositions.resize(frame.positions.size());
+    for (size_t i = lastPositions_.size(); i < frame.positions.size(); i++)
+      frame.previousPositions[i] = frame.positions[i];
+    lastPositions_ = frame.positions;
+
+    if (stepSeconds > 0.0f)
+      step_++;
+    frame.step = step_;
+    frame.stepSeconds = stepSeconds;
+    frame.observables = engine_->GetLastObservables();
+    frame.publishedAt = std::chrono::steady_clock::now();
+
+    // Submitting only copies the frame, the recorder's writer thread does the rest
+    if (stepSeconds > 0.0f)
+    {
+      std::lock_guard lock(recorderMutex_);
+      if (recorder_ && step_ % recordInterval_ == 0)
+        recorder_->Submit({step_, display, engine_->particleRadius, stepSeconds, frame.positions, velocities_, frame.types});
+    }
+    frames_.Publish();
+  }
+}
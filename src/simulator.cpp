@@ -3,16 +3,26 @@
 // Project Includes
 #include "plpp/clock.h"
 #include "plpp/constants.h"
+#include "plpp/gpu_profiler.h"
+#include "plpp/profiler.h"
 #include "plpp/resource_manager.h"
 #include "plpp/shader.h"
+#include "plpp/snapshot.h"
+#include "plpp/trajectory_recorder.h"
 
 // External Libraries
 #include <glm/glm.hpp>
 #include <imgui.h>
 
 // C++ Standard Library
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <utility>
 
 namespace PLPP
 {
@@ -98,14 +108,32 @@ namespace PLPP
 
       std::cerr << "\n\n";
     }
+
+    Shader loadParticleShader(ParticlePrimitive primitive, std::string name)
+    {
+      return ResourceManager::LoadShader("res/shaders/particles.vert", "res/shaders/particles.frag", std::move(name),
+                                         {{"PARTICLE_PRIMITIVE", static_cast<int>(primitive)}});
+    }
   }
 
   Simulator::Simulator()
       : state_(SimulatorState::Idle),
         window_(Init()),
-        physicsEngine_(ResourceManager::LoadShader("res/shaders/particles.comp", "computeShader")),
-        overlay_(window_, physicsEngine_),
-        particleShader_(ResourceManager::LoadShader("res/shaders/particles.vert", "res/shaders/particles.frag", "particleShader")) {}
+        physicsEngine_(),
+        // The render thread keeps a core of its own
+        simulationThread_(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1)),
+        overlay_(window_, physicsEngine_, timestep_),
+        particleShaders_{loadParticleShader(ParticlePrimitive::Quads, "particleShader"),
+                         loadParticleShader(ParticlePrimitive::Points, "particlePointShader"),
+                         loadParticleShader(ParticlePrimitive::Pixels, "particlePixelShader")}
+  {
+    GLfloat pointSizeRange[2] = {1.0f, 1.0f};
+    glGetFloatv(GL_POINT_SIZE_RANGE, pointSizeRange);
+    maximumPointRadius_ = pointSizeRange[1] * 0.5f;
+    physicsEngine_.autoSelectKernel = true;
+    glGenBuffers(3, frameBuffers_);
+    Profiler::Enabled = true;
+  }
 
   void Simulator::Start()
   {
@@ -122,12 +150,18 @@ namespace PLPP
 
     while (!glfwWindowShouldClose(window_))
     {
-      double deltaTime = std::min(clock_.GetDeltaTime(), 0.05);
+      double frameSeconds = clock_.GetDeltaTime();
 
       ProcessInput();
-      Update(deltaTime);
+      Update(frameSeconds);
       Render();
+      PLPP_PROFILE_GPU_END_FRAME();
+      PLPP_PROFILE_END_FRAME();
     }
+    simulationThread_.Stop();
+    setRecordingEnabled(false);
+    setReplayEnabled(false);
+    ResourceManager::StoreProgramBinaries();
   }
 
   GLFWwindow *Simulator::Init()
@@ -172,6 +206,7 @@ namespace PLPP
 
   void Simulator::ProcessInput()
   {
+    PLPP_PROFILE_SCOPE("Input");
     int displayWidth, displayHeight;
     glfwGetFramebufferSize(window_, &displayWidth, &displayHeight);
 
@@ -181,62 +216,300 @@ namespace PLPP
     if (ImGui::IsKeyPressed(ImGuiKey_Q) && ImGui::IsKeyDown(ImGuiMod_Ctrl))
       overlay_.settingsAndConfigsMenuEnabled = !overlay_.settingsAndConfigsMenuEnabled;
 
-    if (ImGui::IsKeyPressed(ImGuiKey_Enter))
+    // Ctrl + S saves the world, Ctrl + L restores it
+    if (ImGui::IsKeyPressed(ImGuiKey_S) && ImGui::IsKeyDown(ImGuiMod_Ctrl))
+      saveSnapshot(SNAPSHOT_FILE);
+    if (ImGui::IsKeyPressed(ImGuiKey_L) && ImGui::IsKeyDown(ImGuiMod_Ctrl))
+      loadSnapshot(SNAPSHOT_FILE);
+
+    // Enter plays and pauses the replay while there is one, the simulation otherwise
+    if (ImGui::IsKeyPressed(ImGuiKey_Enter) && player_.IsOpen())
+      overlay_.replayPaused = !overlay_.replayPaused;
+    else if (ImGui::IsKeyPressed(ImGuiKey_Enter))
       state_ = state_ == SimulatorState::Paused ? SimulatorState::Running : SimulatorState::Paused;
 
-    if (ImGui::IsKeyPressed(ImGuiKey_1))
-      physicsEngine_.AddParticle(0, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+    // Digits 1-9 and 0 add a particle of type 0-9, holding shift spawns a whole batch of that type
+    for (int typeId = 0; typeId < 10; typeId++)
+    {
+      ImGuiKey key = typeId < 9 ? static_cast<ImGuiKey>(ImGuiKey_1 + typeId) : ImGuiKey_0;
+      if (!ImGui::IsKeyPressed(key))
+        continue;
+
+      glm::ivec2 display(displayWidth, displayHeight);
+      if (ImGui::IsKeyDown(ImGuiMod_Shift))
+      {
+        SpawnDistribution distribution = SpawnDistribution::SingleType(typeId, BULK_SPAWN_COUNT, static_cast<uint32_t>(std::rand()));
+        if (simulationThread_.IsRunning())
+          simulationThread_.SpawnParticles(distribution, display);
+        else
+          physicsEngine_.SpawnParticles(distribution, display);
+      }
+      else
+      {
+        glm::vec2 position(std::rand() % displayWidth, std::rand() % displayHeight);
+        if (simulationThread_.IsRunning())
+          simulationThread_.AddParticles({&typeId, 1}, {&position, 1});
+        else
+          physicsEngine_.AddParticle(typeId, position, glm::vec2());
+      }
+    }
+  }
+
+  void Simulator::Update(double frameSeconds)
+  {
+    PLPP_PROFILE_SCOPE("Update");
+    int displayWidth, displayHeight;
+    glfwGetFramebufferSize(window_, &displayWidth, &displayHeight);
+
+    glm::ivec2 display(displayWidth, displayHeight);
 
-    if (ImGui::IsKeyPressed(ImGuiKey_2))
-      physicsEngine_.AddParticle(1, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+    physicsEngine_.collectObservables = overlay_.observablesEnabled;
+    if (overlay_.simulationThreadEnabled != simulationThread_.IsRunning())
+      setSimulationThreadEnabled(overlay_.simulationThreadEnabled);
+    if (overlay_.replayEnabled != player_.IsOpen())
+      setReplayEnabled(overlay_.replayEnabled);
+    if (overlay_.recordingEnabled != recorder_.IsOpen())
+      setRecordingEnabled(overlay_.recordingEnabled);
+    int recordInterval = overlay_.recordInterval;
 
-    if (ImGui::IsKeyPressed(ImGuiKey_3))
-      physicsEngine_.AddParticle(2, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+    if (player_.IsOpen())
+    {
+      // No physics while replaying, a running simulation thread is held where it was
+      simulationThread_.SetPaused(true);
+      player_.speed = overlay_.replaySpeed;
+      player_.paused = overlay_.replayPaused;
+      if (overlay_.replaySeekRequested)
+        player_.Seek(overlay_.replayPlayhead);
+      player_.Update(frameSeconds);
+      overlay_.replaySeekRequested = false;
+      overlay_.replayPaused = player_.paused;
+      overlay_.replayPlayhead = player_.GetPlayhead();
+      overlay_.stepRate = 0.0;
+      overlay_.particleCount = static_cast<int>(player_.GetFrame().current.positions.size());
+    }
+    else if (simulationThread_.IsRunning())
+    {
+      // The overlay keeps editing physicsEngine_, the thread takes the changes between two steps
+      simulationThread_.SetParameters(physicsEngine_);
+      simulationThread_.SetTimestep(timestep_);
+      simulationThread_.SetDisplay(display);
+      simulationThread_.SetPaused(state_ != SimulatorState::Running);
+      simulationThread_.SetRecorder(recorder_.IsOpen() ? &recorder_ : nullptr, recordInterval);
+      overlay_.stepRate = simulationThread_.GetStepRate();
+      overlay_.particleCount = static_cast<int>(simulationThread_.GetFrame().positions.size());
+      overlay_.observables = simulationThread_.GetFrame().observables;
+    }
+    else
+    {
+      // Physics runs at its own fixed rate, 0..maxSubsteps steps per frame
+      int steps = state_ == SimulatorState::Running ? timestep_.Advance(frameSeconds) : 0;
+      if (recorder_.IsOpen())
+      {
+        // Batches end on the recorded steps, their state is copied behind the step without waiting for it
+        for (int remaining = steps; remaining > 0 && physicsEngine_.particleCount > 0;)
+        {
+          int batch = std::min(remaining, recordInterval - static_cast<int>(physicsEngine_.GetStepCount() % recordInterval));
+          physicsEngine_.Advance(timestep_.GetStepSeconds(), display, batch);
+          remaining -= batch;
+          if (physicsEngine_.GetStepCount() % recordInterval == 0)
+            capture_.Capture(physicsEngine_, recorder_, display, timestep_.GetStepSeconds());
+        }
+        capture_.Poll(recorder_);
+      }
+      else
+      {
+        physicsEngine_.Advance(timestep_.GetStepSeconds(), display, steps);
+      }
+      stepRate_.Tick(steps);
+      overlay_.stepRate = stepRate_.GetRate();
+      overlay_.particleCount = physicsEngine_.particleCount;
+      physicsEngine_.PollObservables();
+      overlay_.observables = physicsEngine_.GetLastObservables();
+    }
+    overlay_.frameRate = frameRate_.GetRate();
+
+    if (overlay_.metricsFileEnabled != metrics_.IsOpen())
+    {
+      if (overlay_.metricsFileEnabled)
+        overlay_.metricsFileEnabled = metrics_.Open("plpp_metrics.csv");
+      else
+        metrics_.Close();
+    }
+    metrics_.Write(overlay_.observables);
+    overlay_.recording = recorder_.GetStatistics();
+  }
+
+  void Simulator::setSimulationThreadEnabled(bool enabled)
+  {
+    if (enabled)
+    {
+      simulationThread_.Start(physicsEngine_);
+      return;
+    }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_4))
-      physicsEngine_.AddParticle(3, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+    simulationThread_.Stop();
+    std::vector<glm::vec2> positions, velocities;
+    std::vector<int> types;
+    simulationThread_.GetEngine().ReadParticles(positions, velocities, types);
+    physicsEngine_.ClearParticles();
+    physicsEngine_.AddParticles(types, positions, velocities);
+    timestep_.Reset();
+  }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_5))
-      physicsEngine_.AddParticle(4, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+  void Simulator::saveSnapshot(const std::filesystem::path &path)
+  {
+    int displayWidth, displayHeight;
+    glfwGetFramebufferSize(window_, &displayWidth, &displayHeight);
+    if (simulationThread_.IsRunning())
+      simulationThread_.SaveSnapshot(path, glm::ivec2(displayWidth, displayHeight));
+    else
+      Snapshot::Save(path, physicsEngine_, glm::ivec2(displayWidth, displayHeight));
+  }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_6))
-      physicsEngine_.AddParticle(5, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+  void Simulator::loadSnapshot(const std::filesystem::path &path)
+  {
+    // The world is restored into the GPU backend, which hands it on to the simulation thread
+    bool threadRunning = simulationThread_.IsRunning();
+    simulationThread_.Stop();
+    auto start = std::chrono::steady_clock::now();
+    if (Snapshot::Load(path, physicsEngine_))
+    {
+      std::cout << std::format("Snapshot {} loaded, {} particles in {:.1f} ms", path.string(), physicsEngine_.particleCount,
+                               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count())
+                << std::endl;
+    }
+    if (threadRunning)
+      simulationThread_.Start(physicsEngine_);
+    timestep_.Reset();
+  }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_7))
-      physicsEngine_.AddParticle(6, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+  void Simulator::setRecordingEnabled(bool enabled)
+  {
+    if (enabled)
+    {
+      overlay_.recordingEnabled = recorder_.Open(TRAJECTORY_FILE);
+      return;
+    }
+    if (!recorder_.IsOpen())
+      return;
+
+    // Neither producer may hold on to the recorder once it is closed
+    simulationThread_.SetRecorder(nullptr);
+    capture_.Flush(recorder_);
+    recorder_.Close();
+    TrajectoryStatistics statistics = recorder_.GetStatistics();
+    std::cout << std::format("Trajectory {} written: {} frames, {} dropped, {:.1f}x smaller than floats", TRAJECTORY_FILE,
+                             statistics.framesWritten, statistics.framesDropped, statistics.GetCompressionRatio())
+              << std::endl;
+  }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_8))
-      physicsEngine_.AddParticle(7, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+  void Simulator::setReplayEnabled(bool enabled)
+  {
+    if (!enabled)
+    {
+      player_.Close();
+      return;
+    }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_9))
-      physicsEngine_.AddParticle(8, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+    // The recorder truncates the very file the player maps
+    overlay_.recordingEnabled = false;
+    setRecordingEnabled(false);
+    overlay_.replayEnabled = player_.Open(TRAJECTORY_FILE);
+    if (!overlay_.replayEnabled)
+      return;
+    player_.paused = false;
+    overlay_.replayPaused = false;
+    overlay_.replayFirstStep = player_.GetFirstStep();
+    overlay_.replayLastStep = player_.GetLastStep();
+    overlay_.replayPlayhead = player_.GetPlayhead();
+    std::cout << std::format("Replaying {}: {} frames, steps {} to {}", TRAJECTORY_FILE, player_.GetFrameCount(),
+                             player_.GetFirstStep(), player_.GetLastStep())
+              << std::endl;
+  }
 
-    if (ImGui::IsKeyPressed(ImGuiKey_0))
-      physicsEngine_.AddParticle(9, glm::vec2(std::rand() % displayWidth, std::rand() % displayHeight), glm::vec2());
+  void Simulator::uploadFrame(std::span<const glm::vec2> positions, std::span<const glm::vec2> previousPositions, std::span<const int> types)
+  {
+    PLPP_PROFILE_SCOPE("Upload Frame");
+    // Orphaning lets the driver hand out fresh storage while earlier draws still read the old one
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, frameBuffers_[0]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, positions.size_bytes(), positions.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, frameBuffers_[1]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, previousPositions.size_bytes(), previousPositions.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, frameBuffers_[2]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, types.size_bytes(), types.data(), GL_STREAM_DRAW);
   }
 
-  void Simulator::Update(float delta)
+  void Simulator::renderParticles(unsigned int positions, unsigned int previousPositions, unsigned int types, float alpha, int particleCount)
   {
-    if (state_ == SimulatorState::Running)
-      physicsEngine_.Update(delta, window_);
+    // The projection maps world units to framebuffer pixels, the radius is the on-screen radius
+    float radius = physicsEngine_.particleRadius;
+    if (overlay_.particlePrimitiveAuto)
+    {
+      if (radius < PARTICLE_PIXEL_RADIUS)
+        overlay_.particlePrimitive = ParticlePrimitive::Pixels;
+      else if (radius <= std::min(maximumPointRadius_, PARTICLE_POINT_MAXIMUM_RADIUS))
+        overlay_.particlePrimitive = ParticlePrimitive::Points;
+      else
+        overlay_.particlePrimitive = ParticlePrimitive::Quads;
+    }
+    // Forced points are still limited to what the driver can rasterize
+    ParticlePrimitive primitive = overlay_.particlePrimitive;
+    if (primitive == ParticlePrimitive::Points && radius > maximumPointRadius_)
+      primitive = ParticlePrimitive::Quads;
+    particleShaders_[static_cast<int>(primitive)].Render(window_, positions, previousPositions, types, physicsEngine_.GetPalette(), radius, alpha,
+                                                         particleCount, primitive);
   }
 
   void Simulator::Render()
   {
+    PLPP_PROFILE_SCOPE("Render");
     // Rendering
     int displayWidth, displayHeight;
     glfwGetFramebufferSize(window_, &displayWidth, &displayHeight);
     glClearColor(0.0f, 0.21f, 0.0f, 1.00f);
     glClear(GL_COLOR_BUFFER_BIT);
-    particleShader_.Render(window_, physicsEngine_.GetParticlePositions(), physicsEngine_.particleRadius, physicsEngine_.colors, physicsEngine_.particleCount);
-    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-    physicsEngine_.SetFence(fence);
+    if (player_.IsOpen())
+    {
+      // Like the simulation thread's frames, the loader's are drawn again until a newer one is decoded
+      if (player_.AcquireFrame())
+      {
+        const ReplayFrame &frame = player_.GetFrame();
+        uploadFrame(frame.current.positions, frame.previousPositions, frame.current.types);
+      }
+      renderParticles(frameBuffers_[0], frameBuffers_[1], frameBuffers_[2], player_.GetAlpha(), static_cast<int>(player_.GetFrame().current.positions.size()));
+    }
+    else if (simulationThread_.IsRunning())
+    {
+      // Never waits for the simulation, the last frame is drawn again until a newer one is out
+      if (simulationThread_.AcquireFrame())
+      {
+        const SimulationFrame &frame = simulationThread_.GetFrame();
+        uploadFrame(frame.positions, frame.previousPositions, frame.types);
+      }
+      const SimulationFrame &frame = simulationThread_.GetFrame();
+      float alpha = state_ == SimulatorState::Running ? frame.GetAlpha(std::chrono::steady_clock::now()) : 1.0f;
+      renderParticles(frameBuffers_[0], frameBuffers_[1], frameBuffers_[2], alpha, static_cast<int>(frame.positions.size()));
+    }
+    else
+    {
+      float alpha = state_ == SimulatorState::Running ? timestep_.GetAlpha() : 1.0f;
+      renderParticles(physicsEngine_.GetParticlePositions(), physicsEngine_.GetPreviousParticlePositions(), physicsEngine_.GetParticleTypes(), alpha,
+                      physicsEngine_.particleCount);
+      physicsEngine_.FencePositions();
+    }
 
     // ImGui
-    overlay_.Render();
+    {
+      PLPP_PROFILE_SCOPE("ImGui");
+      overlay_.Render();
+    }
 
     // Call & Swap
-    glfwSwapBuffers(window_);
+    {
+      PLPP_PROFILE_SCOPE("Swap Buffers");
+      glfwSwapBuffers(window_);
+    }
     glfwPollEvents();
+    frameRate_.Tick();
   }
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "plpp/snapshot.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/mapped_file.h"
+#include "plpp/physics_engine.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <vector>
+
+namespace PLPP
+{
+  namespace
+  {
+    uint64_t alignUp(uint64_t value)
+    {
+      return (value + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    }
+
+    // Whether count elements of T fit at offset and are aligned for T
+    template <typename T>
+    bool isSection(const SnapshotHeader &header, uint64_t offset, uint64_t count)
+    {
+      return offset % alignof(T) == 0 && offset >= header.headerSize && offset <= header.fileSize &&
+             count <= (header.fileSize - offset) / sizeof(T);
+    }
+  }
+
+  bool Snapshot::Save(const std::filesystem::path &path, PhysicsEngine &engine, glm::ivec2 display)
+  {
+    std::vector<glm::vec2> positions, velocities;
+    std::vector<int> types;
+    engine.ReadParticles(positions, velocities, types);
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.maximumTypes = MAXIMUM_PARTICLE_TYPES;
+    header.typeCount = types.empty() ? 0 : *std::max_element(types.begin(), types.end()) + 1;
+    header.particleCount = positions.size();
+    header.displayWidth = display.x;
+    header.displayHeight = display.y;
+    header.parameters = {engine.friction, engine.particleRadius, engine.forceMultiplier, engine.effectiveForceRadius, engine.forceLawInnerRadius,
+                         static_cast<int32_t>(engine.boundaryMode), static_cast<int32_t>(engine.forceLaw), engine.useSpatialGrid, engine.autoSelectKernel, {}};
+
+    uint64_t forcesSize = sizeof(float) * MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES;
+    uint64_t colorsSize = sizeof(glm::vec4) * MAXIMUM_PARTICLE_TYPES;
+    uint64_t vec2Size = sizeof(glm::vec2) * header.particleCount, intSize = sizeof(int32_t) * header.particleCount;
+    header.forcesOffset = alignUp(sizeof(SnapshotHeader));
+    header.colorsOffset = alignUp(header.forcesOffset + forcesSize);
+    header.positionsOffset = alignUp(header.colorsOffset + colorsSize);
+    header.velocitiesOffset = alignUp(header.positionsOffset + vec2Size);
+    header.typesOffset = alignUp(header.velocitiesOffset + vec2Size);
+    header.fileSize = header.typesOffset + intSize;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    uint64_t written = 0;
+    auto writeSection = [&](uint64_t offset, const void *data, uint64_t size)
+    {
+      static const char padding[SNAPSHOT_ALIGNMENT] = {};
+      file.write(padding, offset - written);
+      file.write(static_cast<const char *>(data), size);
+      written = offset + size;
+    };
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.forcesOffset, engine.GetForcesBuffer(), forcesSize);
+    writeSection(header.colorsOffset, engine.GetColorsBuffer(), colorsSize);
+    writeSection(header.positionsOffset, positions.data(), vec2Size);
+    writeSection(header.velocitiesOffset, velocities.data(), vec2Size);
+    writeSection(header.typesOffset, types.data(), intSize);
+    file.close();
+
+    if (!file)
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: Failed to write '{}'", path.string()) << std::endl;
+      return false;
+    }
+    std::cout << std::format("Snapshot of {} particles written to {}", header.particleCount, path.string()) << std::endl;
+    return true;
+  }
+
+  bool Snapshot::Load(const std::filesystem::path &path, PhysicsEngine &engine, glm::ivec2 *display)
+  {
+    MappedFile file;
+    if (!file.Open(path))
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: Failed to map '{}'", path.string()) << std::endl;
+      return false;
+    }
+    // The whole file is copied out front to back right away, let the OS read ahead
+    file.Prefetch(0, file.GetSize());
+
+    SnapshotHeader header;
+    if (file.GetSize() < sizeof(SnapshotHeader))
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: '{}' is too small for a snapshot", path.string()) << std::endl;
+      return false;
+    }
+    std::memcpy(&header, file.GetData(), sizeof(SnapshotHeader));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: '{}' is not a version {} snapshot", path.string(), VERSION) << std::endl;
+      return false;
+    }
+    uint64_t matrixSize = static_cast<uint64_t>(header.maximumTypes) * header.maximumTypes;
+    if (header.headerSize < sizeof(SnapshotHeader) || header.fileSize > file.GetSize() || header.particleCount > INT32_MAX ||
+        header.typeCount < 0 || header.typeCount > MAXIMUM_PARTICLE_TYPES ||
+        !isSection<float>(header, header.forcesOffset, matrixSize) ||
+        !isSection<glm::vec4>(header, header.colorsOffset, header.maximumTypes) ||
+        !isSection<glm::vec2>(header, header.positionsOffset, header.particleCount) ||
+        !isSection<glm::vec2>(header, header.velocitiesOffset, header.particleCount) ||
+        !isSection<int32_t>(header, header.typesOffset, header.particleCount))
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: '{}' is truncated or corrupt", path.string()) << std::endl;
+      return false;
+    }
+    // The types index the force matrix, one out of range would have the backends read past it
+    const int32_t *types = reinterpret_cast<const int32_t *>(file.GetData() + header.typesOffset);
+    if (std::any_of(types, types + header.particleCount, [&](int32_t type)
+                    { return type < 0 || type >= header.typeCount; }))
+    {
+      std::cerr << std::format("ERROR::SNAPSHOT: '{}' has particles of types it does not define", path.string()) << std::endl;
+      return false;
+    }
+
+    const SnapshotParameters &parameters = header.parameters;
+    engine.friction = parameters.friction;
+    engine.particleRadius = parameters.particleRadius;
+    engine.forceMultiplier = parameters.forceMultiplier;
+    engine.effectiveForceRadius = parameters.effectiveForceRadius;
+    engine.forceLawInnerRadius = parameters.forceLawInnerRadius;
+    engine.boundaryMode = static_cast<BoundaryMode>(std::clamp(parameters.boundaryMode, 0, static_cast<int32_t>(BoundaryMode::Reflect)));
+    engine.forceLaw = static_cast<ForceLaw>(std::clamp(parameters.forceLaw, 0, static_cast<int32_t>(ForceLaw::InverseSquare)));
+    engine.useSpatialGrid = parameters.useSpatialGrid != 0;
+    engine.autoSelectKernel = parameters.autoSelectKernel != 0;
+
+    // A snapshot from a build with another type limit keeps the types both builds know
+    const float *forces = reinterpret_cast<const float *>(file.GetData() + header.forcesOffset);
+    const glm::vec4 *colors = reinterpret_cast<const glm::vec4 *>(file.GetData() + header.colorsOffset);
+    int sharedTypes = std::min<int>(header.maximumTypes, MAXIMUM_PARTICLE_TYPES);
+    float *forceBuffer = engine.GetForcesBuffer();
+    std::fill(forceBuffer, forceBuffer + MAXIMUM_PARTICLE_TYPES * MAXIMUM_PARTICLE_TYPES, 0.0f);
+    for (int row = 0; row < sharedTypes; row++)
+      std::copy(forces + row * header.maximumTypes, forces + row * header.maximumTypes + sharedTypes, forceBuffer + row * MAXIMUM_PARTICLE_TYPES);
+    std::copy(colors, colors + sharedTypes, engine.GetColorsBuffer());
+
+    // Straight from the mapping into the backend's storage
+    size_t count = header.particleCount;
+    engine.ClearParticles();
+    engine.AddParticles({types, count},
+                        {reinterpret_cast<const glm::vec2 *>(file.GetData() + header.positionsOffset), count},
+                        {reinterpret_cast<const glm::vec2 *>(file.GetData() + header.velocitiesOffset), count});
+
+    if (display)
+      *display = glm::ivec2(header.displayWidth, header.displayHeight);
+    return true;
+  }
+}
@@ -0,0 +1,104 @@
+#include "plpp/spawn_distribution.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace PLPP
+{
+  namespace
+  {
+    // Draws of a particle, seed.comp uses the same numbering
+    enum Stream : uint32_t
+    {
+      TypeStream,
+      PositionXStream,
+      PositionYStream,
+      ClusterStream,
+      ClusterDistanceStream,
+      ClusterAngleStream,
+      CentreXStream,
+      CentreYStream
+    };
+
+    uint32_t pcgHash(uint32_t value)
+    {
+      uint32_t state = value * 747796405u + 2891336453u;
+      uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+      return (word >> 22u) ^ word;
+    }
+  }
+
+  uint32_t SpawnDistribution::Random(uint32_t seed, uint32_t index, uint32_t stream)
+  {
+    return pcgHash(index ^ pcgHash(seed + stream * 0x9E3779B9u));
+  }
+
+  float SpawnDistribution::RandomFloat(uint32_t seed, uint32_t index, uint32_t stream)
+  {
+    return static_cast<float>(Random(seed, index, stream) >> 8) * (1.0f / 16777216.0f);
+  }
+
+  SpawnDistribution SpawnDistribution::SingleType(int typeId, int count, uint32_t seed)
+  {
+    SpawnDistribution distribution;
+    distribution.count = count;
+    distribution.typeWeights.assign(typeId + 1, 0.0f);
+    distribution.typeWeights[typeId] = 1.0f;
+    distribution.seed = seed;
+    return distribution;
+  }
+
+  std::vector<float> SpawnDistribution::GetTypeThresholds() const
+  {
+    float total = 0.0f;
+    for (float weight : typeWeights)
+      total += std::max(weight, 0.0f);
+
+    std::vector<float> thresholds(typeWeights.size());
+    float running = 0.0f;
+    for (size_t i = 0; i < typeWeights.size(); i++)
+    {
+      running += std::max(typeWeights[i], 0.0f);
+      thresholds[i] = total > 0.0f ? running / total : static_cast<float>(i + 1) / typeWeights.size();
+    }
+    // Rounding must not leave a gap below 1
+    if (!thresholds.empty())
+      thresholds.back() = 1.0f;
+    return thresholds;
+  }
+
+  int SpawnDistribution::SampleType(uint32_t index, const std::vector<float> &typeThresholds) const
+  {
+    float draw = RandomFloat(seed, index, TypeStream);
+    int type = 0;
+    while (type < static_cast<int>(typeThresholds.size()) - 1 && draw >= typeThresholds[type])
+      type++;
+    return type;
+  }
+
+  glm::vec2 SpawnDistribution::SamplePosition(uint32_t index, glm::vec2 display) const
+  {
+    glm::vec2 position;
+    if (layout == SpawnLayout::Clustered && clusterCount > 0)
+    {
+      uint32_t cluster = Random(seed, index, ClusterStream) % static_cast<uint32_t>(clusterCount);
+      glm::vec2 centre(RandomFloat(seed, cluster, CentreXStream) * display.x, RandomFloat(seed, cluster, CentreYStream) * display.y);
+      // sqrt keeps the density uniform over the disc
+      float distance = clusterRadius * std::sqrt(RandomFloat(seed, index, ClusterDistanceStream));
+      float angle = 6.28318530718f * RandomFloat(seed, index, ClusterAngleStream);
+      position = centre + distance * glm::vec2(std::cos(angle), std::sin(angle));
+    }
+    else
+    {
+      position = glm::vec2(RandomFloat(seed, index, PositionXStream), RandomFloat(seed, index, PositionYStream)) * display;
+    }
+    // Wrap like the simulation does, GLSL mod semantics
+    return glm::vec2(position.x - display.x * std::floor(position.x / display.x), position.y - display.y * std::floor(position.y / display.y));
+  }
+}
@@ -0,0 +1,162 @@
+#include "plpp/subdomain_worker.h"
+
+// Project Includes
+#include "plpp/cpu_physics_engine.h"
+#include "plpp/halo_exchange.h"
+#include "plpp/scenario.h"
+#include "plpp/strip_decomposition.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace PLPP
+{
+  using Direction = HaloExchange::Direction;
+
+  SubdomainWorker::SubdomainWorker(HaloExchange &exchange, int rank, Scenario scenario, uint64_t seed, int threadCount)
+      : exchange_(exchange), rank_(rank), display_(scenario.display), engine_(threadCount)
+  {
+    // Every worker draws the whole world from the seed, which costs less than shipping it
+    scenario.Apply(engine_, seed);
+    scenario.Spawn(engine_, seed);
+    decomposition_ = StripDecomposition::Fit(display_, engine_.particleRadius, exchange_.GetWorkerCount());
+
+    engine_.ReadParticles(positions_, velocities_, types_);
+    std::vector<int> foreign;
+    for (int slot = 0; slot < engine_.particleCount; slot++)
+    {
+      if (decomposition_.GetOwner(positions_[slot].x) == rank_)
+        ids_.push_back(slot);
+      else
+        foreign.push_back(slot);
+    }
+    engine_.RemoveParticles(foreign);
+  }
+
+  bool SubdomainWorker::Step(float deltaTime)
+  {
+    auto exchangeStart = std::chrono::steady_clock::now();
+    int workerCount = decomposition_.workerCount;
+    if (workerCount > 1)
+    {
+      engine_.ReadParticles(positions_, velocities_, types_);
+      emigrantSlots_.clear();
+      haloTypes_.clear();
+      haloPositions_.clear();
+      immigrants_.clear();
+
+      HaloExchange::Mailbox outboxes[2] = {exchange_.GetMailbox(rank_, Direction::Left, parity_),
+                                           exchange_.GetMailbox(rank_, Direction::Right, parity_)};
+      int counts[2] = {0, 0};
+
+      // Particles that left the strip move to the neighbour on the shorter way around the ring.
+      // They stay here as halo particles, the strip still feels them this step.
+      for (int slot = 0; slot < engine_.particleCount; slot++)
+      {
+        int owner = decomposition_.GetOwner(positions_[slot].x);
+        if (owner == rank_)
+          continue;
+        int side = (owner - rank_ + workerCount) % workerCount <= workerCount / 2 ? 1 : 0;
+        outboxes[side].records[counts[side]++] = {positions_[slot].x, positions_[slot].y, velocities_[slot].x, velocities_[slot].y, types_[slot], ids_[slot]};
+        emigrantSlots_.push_back(slot);
+        haloTypes_.push_back(types_[slot]);
+        haloPositions_.push_back(positions_[slot]);
+      }
+      int migrantCounts[2] = {counts[0], counts[1]};
+
+      // Halo particles, except across the display edges
+      float radius = engine_.effectiveForceRadius;
+      for (int slot = 0; slot < engine_.particleCount; slot++)
+      {
+        glm::vec2 position = positions_[slot];
+        if (decomposition_.GetOwner(position.x) != rank_)
+          continue;
+        ParticleRecord record = {position.x, position.y, 0.0f, 0.0f, types_[slot], ids_[slot]};
+        if (rank_ > 0 && position.x < decomposition_.GetBegin(rank_) + radius)
+          outboxes[0].records[counts[0]++] = record;
+        if (rank_ < workerCount - 1 && position.x >= decomposition_.GetEnd(rank_) - radius)
+          outboxes[1].records[counts[1]++] = record;
+      }
+
+      exchange_.PostMailbox(rank_, Direction::Left, parity_, migrantCounts[0], counts[0] - migrantCounts[0]);
+      exchange_.PostMailbox(rank_, Direction::Right, parity_, migrantCounts[1], counts[1] - migrantCounts[1]);
+      if (!exchange_.Arrive())
+        return false;
+
+      // With two workers both neighbours are the same process, its two mailboxes stay distinct
+      receive(exchange_.GetMailbox(decomposition_.GetLeft(rank_), Direction::Right, parity_));
+      receive(exchange_.GetMailbox(decomposition_.GetRight(rank_), Direction::Left, parity_));
+      parity_ ^= 1;
+
+      removeSlots(emigrantSlots_);
+      std::vector<int> immigrantTypes;
+      std::vector<glm::vec2> immigrantPositions, immigrantVelocities;
+      for (const ParticleRecord &record : immigrants_)
+      {
+        immigrantTypes.push_back(record.type);
+        immigrantPositions.emplace_back(record.x, record.y);
+        immigrantVelocities.emplace_back(record.vx, record.vy);
+        ids_.push_back(record.id);
+      }
+      engine_.AddParticles(immigrantTypes, immigrantPositions, immigrantVelocities);
+      engine_.SetHaloParticles(haloTypes_, haloPositions_);
+
+      migrants_ += immigrants_.size();
+      haloParticles_ += haloTypes_.size();
+    }
+    exchangeSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - exchangeStart).count();
+
+    engine_.Update(deltaTime, display_);
+    return true;
+  }
+
+  void SubdomainWorker::Finish(double stepSeconds)
+  {
+    engine_.ReadParticles(positions_, velocities_, types_);
+    std::vector<ParticleRecord> particles(engine_.particleCount);
+    for (int slot = 0; slot < engine_.particleCount; slot++)
+      particles[slot] = {positions_[slot].x, positions_[slot].y, velocities_[slot].x, velocities_[slot].y, types_[slot], ids_[slot]};
+    exchange_.Gather(particles);
+
+    WorkerReport &report = exchange_.GetReport(rank_);
+    report.particleCount = engine_.particleCount;
+    report.stepSeconds = stepSeconds;
+    report.exchangeSeconds = exchangeSeconds_;
+    report.migrants = migrants_;
+    report.haloParticles = haloParticles_;
+  }
+
+  void SubdomainWorker::removeSlots(const std::vector<int> &slots)
+  {
+    engine_.RemoveParticles(slots);
+    // Same compaction as the engine, so ids_ keeps matching the slots
+    size_t next = 0;
+    size_t kept = 0;
+    for (size_t slot = 0; slot < ids_.size(); slot++)
+    {
+      if (next < slots.size() && slots[next] == static_cast<int>(slot))
+      {
+        next++;
+        continue;
+      }
+      ids_[kept++] = ids_[slot];
+    }
+    ids_.resize(kept);
+  }
+
+  void SubdomainWorker::receive(HaloExchange::Mailbox mailbox)
+  {
+    for (int i = 0; i < mailbox.migrantCount; i++)
+      immigrants_.push_back(mailbox.records[i]);
+    for (int i = mailbox.migrantCount; i < mailbox.migrantCount + mailbox.haloCount; i++)
+    {
+      haloTypes_.push_back(mailbox.records[i].type);
+      haloPositions_.emplace_back(mailbox.records[i].x, mailbox.records[i].y);
+    }
+  }
+}
@@ -0,0 +1,132 @@
+#include "plpp/thread_pool.h"
+
+// C++ Standard Library
+#include <algorithm>
+
+namespace PLPP
+{
+  ThreadPool::ThreadPool(int threadCount)
+  {
+    if (threadCount <= 0)
+      threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < threadCount; i++)
+      queues_.push_back(std::make_unique<WorkerQueue>());
+    for (int i = 1; i < threadCount; i++)
+      workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+    for (std::thread &worker : workers_)
+      worker.join();
+  }
+
+  void ThreadPool::ParallelFor(int count, int grainSize, const std::function<void(int, int)> &task)
+  {
+    if (count <= 0)
+      return;
+
+    grainSize = std::max(1, grainSize);
+    int chunkCount = (count + grainSize - 1) / grainSize;
+    int threadCount = GetThreadCount();
+    if (threadCount == 1 || chunkCount == 1)
+    {
+      task(0, count);
+      return;
+    }
+
+    task_ = &task;
+    remainingChunks_.store(chunkCount, std::memory_order_relaxed);
+
+    // Hand every worker a contiguous run of chunks so the common case stays cache friendly
+    for (int worker = 0; worker < threadCount; worker++)
+    {
+      int firstChunk = static_cast<int>(static_cast<int64_t>(chunkCount) * worker / threadCount);
+      int lastChunk = static_cast<int>(static_cast<int64_t>(chunkCount) * (worker + 1) / threadCount);
+      std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+      for (int chunk = firstChunk; chunk < lastChunk; chunk++)
+        queues_[worker]->chunks.emplace_back(chunk * grainSize, std::min(count, (chunk + 1) * grainSize));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      generation_++;
+    }
+    wakeCondition_.notify_all();
+
+    while (runChunk(0))
+      ;
+
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    doneCondition_.wait(lock, [this]
+                        { return remainingChunks_.load(std::memory_order_acquire) == 0; });
+    task_ = nullptr;
+  }
+
+  void ThreadPool::workerLoop(int index)
+  {
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait(lock, [&]
+                            { return stopping_ || generation_ != seenGeneration; });
+        if (stopping_)
+          return;
+        seenGeneration = generation_;
+      }
+
+      while (runChunk(index))
+        ;
+    }
+  }
+
+  bool ThreadPool::runChunk(int index)
+  {
+    std::pair<int, int> chunk;
+    bool found = false;
+    {
+      WorkerQueue &own = *queues_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.chunks.empty())
+      {
+        chunk = own.chunks.back();
+        own.chunks.pop_back();
+        found = true;
+      }
+    }
+
+    int threadCount = GetThreadCount();
+    for (int offset = 1; !found && offset < threadCount; offset++)
+    {
+      WorkerQueue &victim = *queues_[(index + offset) % threadCount];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.chunks.empty())
+      {
+        chunk = victim.chunks.front();
+        victim.chunks.pop_front();
+        found = true;
+        steals_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    if (!found)
+      return false;
+
+    (*task_)(chunk.first, chunk.second);
+
+    if (remainingChunks_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      doneCondition_.notify_all();
+    }
+    return true;
+  }
+}
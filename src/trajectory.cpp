@@ -0,0 +1,306 @@
+#include "plpp/trajectory.h"
+
+// Project Includes
+#include "plpp/constants.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace PLPP
+{
+  static_assert(MAXIMUM_PARTICLE_TYPES <= 256, "Trajectory keyframes store particle types as bytes");
+
+  namespace
+  {
+    // Residuals are packed in blocks of this many values, each block at the bit width of its largest
+    constexpr size_t PACK_BLOCK = 32;
+
+    // Every block is a byte holding its bit width followed by the values at that width
+    void packBlocks(std::span<const uint32_t> values, std::vector<uint8_t> &out)
+    {
+      for (size_t begin = 0; begin < values.size(); begin += PACK_BLOCK)
+      {
+        size_t end = std::min(begin + PACK_BLOCK, values.size());
+        uint32_t combined = 0;
+        for (size_t i = begin; i < end; i++)
+          combined |= values[i];
+        int width = std::bit_width(combined);
+        out.push_back(static_cast<uint8_t>(width));
+
+        uint64_t bits = 0;
+        int pending = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+          bits |= static_cast<uint64_t>(values[i]) << pending;
+          pending += width;
+          for (; pending >= 8; pending -= 8, bits >>= 8)
+            out.push_back(static_cast<uint8_t>(bits));
+        }
+        if (pending > 0)
+          out.push_back(static_cast<uint8_t>(bits));
+      }
+    }
+
+    bool unpackBlocks(const uint8_t *&cursor, const uint8_t *end, std::span<uint32_t> values)
+    {
+      for (size_t begin = 0; begin < values.size(); begin += PACK_BLOCK)
+      {
+        size_t blockEnd = std::min(begin + PACK_BLOCK, values.size());
+        if (cursor >= end || *cursor > 32)
+          return false;
+        int width = *cursor++;
+        if (static_cast<size_t>(end - cursor) < ((blockEnd - begin) * width + 7) / 8)
+          return false;
+
+        uint64_t bits = 0;
+        int available = 0;
+        uint64_t mask = (uint64_t{1} << width) - 1;
+        for (size_t i = begin; i < blockEnd; i++)
+        {
+          for (; available < width; available += 8)
+            bits |= static_cast<uint64_t>(*cursor++) << available;
+          values[i] = static_cast<uint32_t>(bits & mask);
+          bits >>= width;
+          available -= width;
+        }
+      }
+      return true;
+    }
+
+    // Small magnitudes of either sign become small unsigned values
+    uint32_t zigzag(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+    int32_t unzigzag(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1u); }
+
+    // Quantized displacement over the frame, computed the same way by the encoder and the decoder
+    int32_t predictMotion(float predictionScale, uint64_t steps, int16_t previous, int16_t current)
+    {
+      int64_t weighted = static_cast<int64_t>(steps - 1) * previous + static_cast<int64_t>(steps + 1) * current;
+      return static_cast<int32_t>(std::lrint(static_cast<double>(predictionScale) * static_cast<double>(weighted)));
+    }
+
+    // False if value rounds to outside [low, high], NaN included
+    bool quantize(double value, int32_t low, int32_t high, int32_t &quantized)
+    {
+      if (!(value >= low - 0.5 && value < high + 0.5))
+        return false;
+      quantized = static_cast<int32_t>(std::lrint(value));
+      return true;
+    }
+
+    float positionScale(float period) { return 65536.0f / period; }
+  }
+
+  void TrajectoryEncoder::Encode(const TrajectoryFrameView &frame, std::vector<uint8_t> &out)
+  {
+    const TrajectoryFrameHeader &last = state_.header;
+    bool sameParticles = state_.valid && frame.positions.size() == last.particleCount &&
+                         frame.display == glm::ivec2(last.displayWidth, last.displayHeight) && frame.step > last.step;
+    for (size_t i = 0; sameParticles && i < frame.types.size(); i++)
+      sameParticles = frame.types[i] == state_.types[i];
+
+    if (!sameParticles || framesSinceKeyframe_ + 1 >= keyframeInterval || !encodeDelta(frame, out))
+      encodeKeyframe(frame, out);
+  }
+
+  void TrajectoryEncoder::encodeKeyframe(const TrajectoryFrameView &frame, std::vector<uint8_t> &out)
+  {
+    size_t count = frame.positions.size();
+    // The wrapped world spans a radius past each edge, one more pixel keeps its far edge inside
+    glm::vec2 low(-frame.particleRadius, -frame.particleRadius);
+    glm::vec2 high(frame.display.x + frame.particleRadius + 1.0f, frame.display.y + frame.particleRadius + 1.0f);
+    float maximumSpeed = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+      glm::vec2 position = frame.positions[i], velocity = frame.velocities[i];
+      if (std::isfinite(position.x) && std::isfinite(position.y))
+      {
+        low = glm::min(low, glm::vec2(std::floor(position.x), std::floor(position.y)) - glm::vec2(1.0f));
+        high = glm::max(high, glm::vec2(std::ceil(position.x), std::ceil(position.y)) + glm::vec2(1.0f));
+      }
+      if (std::isfinite(velocity.x) && std::isfinite(velocity.y))
+        maximumSpeed = std::max({maximumSpeed, std::abs(velocity.x), std::abs(velocity.y)});
+    }
+
+    TrajectoryFrameHeader &header = state_.header;
+    header = {};
+    header.tag = FRAME_TAG;
+    header.flags = TRAJECTORY_KEYFRAME;
+    header.step = frame.step;
+    header.particleCount = static_cast<uint32_t>(count);
+    header.displayWidth = frame.display.x;
+    header.displayHeight = frame.display.y;
+    header.originX = low.x;
+    header.originY = low.y;
+    header.periodX = high.x - low.x;
+    header.periodY = high.y - low.y;
+    // Headroom so the velocities can grow until the next keyframe
+    header.velocityScale = std::max(2.0f * maximumSpeed, TRAJECTORY_MINIMUM_VELOCITY_RANGE) / INT16_MAX;
+    header.stepSeconds = frame.stepSeconds;
+
+    state_.positions.resize(2 * count);
+    state_.velocities.resize(2 * count);
+    state_.types.resize(count);
+    float scaleX = positionScale(header.periodX), scaleY = positionScale(header.periodY);
+    for (size_t i = 0; i < count; i++)
+    {
+      glm::vec2 position = frame.positions[i], velocity = frame.velocities[i] / header.velocityScale;
+      // Invalid values are stored as the origin and at rest
+      auto store = [](float value, float low, float high) -> int32_t
+      { return std::isfinite(value) ? static_cast<int32_t>(std::lrint(std::clamp(value, low, high))) : 0; };
+      state_.positions[2 * i] = static_cast<uint16_t>(store((position.x - header.originX) * scaleX, 0.0f, UINT16_MAX));
+      state_.positions[2 * i + 1] = static_cast<uint16_t>(store((position.y - header.originY) * scaleY, 0.0f, UINT16_MAX));
+      state_.velocities[2 * i] = static_cast<int16_t>(store(velocity.x, INT16_MIN, INT16_MAX));
+      state_.velocities[2 * i + 1] = static_cast<int16_t>(store(velocity.y, INT16_MIN, INT16_MAX));
+      state_.types[i] = static_cast<uint8_t>(frame.types[i]);
+    }
+
+    header.payloadSize = static_cast<uint32_t>(count * (sizeof(uint8_t) + 2 * sizeof(uint16_t) + 2 * sizeof(int16_t)));
+    size_t start = out.size();
+    out.resize(start + sizeof(header) + header.payloadSize);
+    uint8_t *cursor = out.data() + start;
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    std::memcpy(cursor, state_.types.data(), count);
+    cursor += count;
+    std::memcpy(cursor, state_.positions.data(), 2 * count * sizeof(uint16_t));
+    cursor += 2 * count * sizeof(uint16_t);
+    std::memcpy(cursor, state_.velocities.data(), 2 * count * sizeof(int16_t));
+
+    state_.valid = true;
+    framesSinceKeyframe_ = 0;
+  }
+
+  bool TrajectoryEncoder::encodeDelta(const TrajectoryFrameView &frame, std::vector<uint8_t> &out)
+  {
+    TrajectoryFrameHeader header = state_.header;
+    uint64_t steps = frame.step - header.step;
+    header.flags = 0;
+    header.step = frame.step;
+    header.stepSeconds = frame.stepSeconds;
+    float scaleX = positionScale(header.periodX), scaleY = positionScale(header.periodY);
+    header.predictionScaleX = 0.5f * frame.stepSeconds * header.velocityScale * scaleX;
+    header.predictionScaleY = 0.5f * frame.stepSeconds * header.velocityScale * scaleY;
+
+    // The state is only updated once the whole frame is known to fit
+    size_t count = header.particleCount;
+    velocities_.resize(2 * count);
+    positions_.resize(2 * count);
+    // One stream per component, velocity x and y then position x and y, so each packs at its own width
+    residuals_.resize(4 * count);
+    for (size_t i = 0; i < count; i++)
+    {
+      glm::vec2 position = frame.positions[i], velocity = frame.velocities[i] / header.velocityScale;
+      int32_t quantized[4];
+      if (!quantize(velocity.x, INT16_MIN, INT16_MAX, quantized[0]) || !quantize(velocity.y, INT16_MIN, INT16_MAX, quantized[1]) ||
+          !quantize((position.x - header.originX) * scaleX, 0, UINT16_MAX, quantized[2]) ||
+          !quantize((position.y - header.originY) * scaleY, 0, UINT16_MAX, quantized[3]))
+        return false;
+
+      for (int axis = 0; axis < 2; axis++)
+      {
+        int16_t previousVelocity = state_.velocities[2 * i + axis];
+        int16_t velocity = static_cast<int16_t>(quantized[axis]);
+        residuals_[axis * count + i] = zigzag(velocity - previousVelocity);
+
+        // Differences are taken modulo 2^16, a particle wrapping around the world moves by one period
+        uint16_t position = static_cast<uint16_t>(quantized[2 + axis]);
+        float predictionScale = axis == 0 ? header.predictionScaleX : header.predictionScaleY;
+        uint16_t predicted = static_cast<uint16_t>(state_.positions[2 * i + axis] + predictMotion(predictionScale, steps, previousVelocity, velocity));
+        residuals_[(2 + axis) * count + i] = zigzag(static_cast<int16_t>(static_cast<uint16_t>(position - predicted)));
+
+        velocities_[2 * i + axis] = velocity;
+        positions_[2 * i + axis] = position;
+      }
+    }
+
+    size_t start = out.size();
+    out.resize(start + sizeof(header));
+    for (int stream = 0; stream < 4; stream++)
+      packBlocks(std::span<const uint32_t>(residuals_).subspan(stream * count, count), out);
+    header.payloadSize = static_cast<uint32_t>(out.size() - start - sizeof(header));
+    std::memcpy(out.data() + start, &header, sizeof(header));
+    state_.header = header;
+    state_.positions.swap(positions_);
+    state_.velocities.swap(velocities_);
+    framesSinceKeyframe_++;
+    return true;
+  }
+
+  bool TrajectoryDecoder::Apply(const TrajectoryFrameHeader &header, std::span<const uint8_t> payload)
+  {
+    size_t count = header.particleCount;
+    if (header.tag != TrajectoryEncoder::FRAME_TAG || payload.size() < header.payloadSize)
+      return false;
+
+    if (header.flags & TRAJECTORY_KEYFRAME)
+    {
+      if (header.payloadSize != count * (sizeof(uint8_t) + 2 * sizeof(uint16_t) + 2 * sizeof(int16_t)))
+        return false;
+      state_.positions.resize(2 * count);
+      state_.velocities.resize(2 * count);
+      state_.types.resize(count);
+      const uint8_t *cursor = payload.data();
+      std::memcpy(state_.types.data(), cursor, count);
+      cursor += count;
+      std::memcpy(state_.positions.data(), cursor, 2 * count * sizeof(uint16_t));
+      cursor += 2 * count * sizeof(uint16_t);
+      std::memcpy(state_.velocities.data(), cursor, 2 * count * sizeof(int16_t));
+      state_.header = header;
+      state_.valid = true;
+      return true;
+    }
+
+    if (!state_.valid || count != state_.header.particleCount || header.step <= state_.header.step)
+      return false;
+    uint64_t steps = header.step - state_.header.step;
+    const uint8_t *cursor = payload.data(), *end = payload.data() + header.payloadSize;
+    residuals_.resize(4 * count);
+    for (int stream = 0; stream < 4; stream++)
+    {
+      if (!unpackBlocks(cursor, end, std::span<uint32_t>(residuals_).subspan(stream * count, count)))
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      for (int axis = 0; axis < 2; axis++)
+      {
+        int16_t previousVelocity = state_.velocities[2 * i + axis];
+        int16_t velocity = static_cast<int16_t>(previousVelocity + unzigzag(residuals_[axis * count + i]));
+        float predictionScale = axis == 0 ? header.predictionScaleX : header.predictionScaleY;
+        uint16_t predicted = static_cast<uint16_t>(state_.positions[2 * i + axis] + predictMotion(predictionScale, steps, previousVelocity, velocity));
+        state_.velocities[2 * i + axis] = velocity;
+        state_.positions[2 * i + axis] = static_cast<uint16_t>(predicted + unzigzag(residuals_[(2 + axis) * count + i]));
+      }
+    }
+    state_.header = header;
+    return true;
+  }
+
+  void TrajectoryDecoder::Read(TrajectoryFrame &frame) const
+  {
+    const TrajectoryFrameHeader &header = state_.header;
+    size_t count = state_.valid ? header.particleCount : 0;
+    frame.step = header.step;
+    frame.display = glm::ivec2(header.displayWidth, header.displayHeight);
+    frame.stepSeconds = header.stepSeconds;
+    frame.positions.resize(count);
+    frame.velocities.resize(count);
+    frame.types.resize(count);
+    glm::vec2 origin(header.originX, header.originY), quantum(header.periodX / 65536.0f, header.periodY / 65536.0f);
+    for (size_t i = 0; i < count; i++)
+    {
+      frame.positions[i] = origin + glm::vec2(state_.positions[2 * i], state_.positions[2 * i + 1]) * quantum;
+      frame.velocities[i] = glm::vec2(state_.velocities[2 * i], state_.velocities[2 * i + 1]) * header.velocityScale;
+      frame.types[i] = state_.types[i];
+    }
+  }
+}
@@ -0,0 +1,131 @@
+#include "plpp/trajectory_capture.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/gpu_physics_engine.h"
+#include "plpp/profiler.h"
+#include "plpp/trajectory_recorder.h"
+
+// External Libraries
+#include <glad/glad.h>
+#include <glfw/glfw3.h>
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <span>
+
+namespace PLPP
+{
+  TrajectoryCapture::~TrajectoryCapture()
+  {
+    // The simulator terminates GLFW before its members are destroyed, nothing left to free then
+    if (!glfwGetCurrentContext())
+      return;
+    for (StagingSlot &slot : slots_)
+    {
+      if (slot.fence)
+        glDeleteSync(slot.fence);
+      if (slot.buffer)
+        glDeleteBuffers(1, &slot.buffer);
+    }
+  }
+
+  void TrajectoryCapture::Capture(GPUPhysicsEngine &engine, TrajectoryRecorder &recorder, glm::ivec2 display, float stepSeconds)
+  {
+    PLPP_PROFILE_SCOPE("Trajectory Capture");
+    Poll(recorder);
+    auto free = std::find_if(std::begin(slots_), std::end(slots_), [](const StagingSlot &slot)
+                             { return slot.state == SlotState::Free; });
+    if (free == std::end(slots_))
+    {
+      recorder.CountDrop();
+      return;
+    }
+
+    StagingSlot &slot = *free;
+    int count = engine.particleCount;
+    if (slot.capacity < count)
+      reserve(slot, engine.GetCapacity());
+
+    // Copies run in order behind the step that wrote the positions, nothing waits here. Buffer
+    // copies only see the force shader's storage writes after this barrier.
+    size_t capacity = static_cast<size_t>(slot.capacity);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, engine.GetParticlePositions());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(glm::vec2) * count);
+    glBindBuffer(GL_COPY_READ_BUFFER, engine.GetParticleVelocities());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, sizeof(glm::vec2) * capacity, sizeof(glm::vec2) * count);
+    glBindBuffer(GL_COPY_READ_BUFFER, engine.GetParticleTypes());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 2 * sizeof(glm::vec2) * capacity, sizeof(int) * count);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.state = SlotState::Copying;
+
+    TrajectoryFrameView &frame = slot.frame;
+    frame.step = engine.GetStepCount();
+    frame.display = display;
+    frame.particleRadius = engine.particleRadius;
+    frame.stepSeconds = stepSeconds;
+    frame.positions = {reinterpret_cast<const glm::vec2 *>(slot.pointer), static_cast<size_t>(count)};
+    frame.velocities = {reinterpret_cast<const glm::vec2 *>(slot.pointer + sizeof(glm::vec2) * capacity), static_cast<size_t>(count)};
+    frame.types = {reinterpret_cast<const int *>(slot.pointer + 2 * sizeof(glm::vec2) * capacity), static_cast<size_t>(count)};
+  }
+
+  void TrajectoryCapture::Poll(TrajectoryRecorder &recorder)
+  {
+    // Oldest first, the writer expects the frames in step order
+    StagingSlot *order[TRAJECTORY_STAGING_FRAMES];
+    for (int i = 0; i < TRAJECTORY_STAGING_FRAMES; i++)
+      order[i] = &slots_[i];
+    std::sort(std::begin(order), std::end(order), [](const StagingSlot *a, const StagingSlot *b)
+              { return a->frame.step < b->frame.step; });
+
+    // Copies finish in order, once one is pending the later ones are as well
+    bool pending = false;
+    for (StagingSlot *slot : order)
+    {
+      if (slot->state == SlotState::Writing && slot->released.load(std::memory_order_acquire))
+        slot->state = SlotState::Free;
+      if (slot->state != SlotState::Copying || pending)
+        continue;
+      GLenum status = glClientWaitSync(slot->fence, 0, 0);
+      pending = status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED;
+      if (pending)
+        continue;
+      glDeleteSync(slot->fence);
+      slot->fence = nullptr;
+      slot->state = recorder.SubmitBorrowed(slot->frame, slot->released) ? SlotState::Writing : SlotState::Free;
+    }
+  }
+
+  void TrajectoryCapture::Flush(TrajectoryRecorder &recorder)
+  {
+    for (StagingSlot &slot : slots_)
+    {
+      if (slot.state == SlotState::Copying)
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+    Poll(recorder);
+  }
+
+  void TrajectoryCapture::reserve(StagingSlot &slot, int capacity)
+  {
+    if (slot.buffer)
+      glDeleteBuffers(1, &slot.buffer);
+    // Read back on the host, client storage asks for cached system memory
+    size_t size = (2 * sizeof(glm::vec2) + sizeof(int)) * static_cast<size_t>(capacity);
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+    slot.pointer = static_cast<unsigned char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+    slot.capacity = capacity;
+    if (!slot.pointer)
+      std::cerr << "Failed to map trajectory staging buffer!\n";
+  }
+}
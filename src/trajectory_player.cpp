@@ -0,0 +1,193 @@
+#include "plpp/trajectory_player.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/mapped_file.h"
+#include "plpp/trajectory.h"
+#include "plpp/trajectory_reader.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace PLPP
+{
+  namespace
+  {
+    // Read ahead is done in pieces of this size, a new target is picked up between two pieces
+    constexpr uint64_t READ_AHEAD_PIECE = 1u << 20;
+    constexpr size_t NO_FRAME = SIZE_MAX;
+  }
+
+  bool TrajectoryPlayer::Open(const std::filesystem::path &path)
+  {
+    Close();
+    if (!reader_.Open(path))
+      return false;
+    if (reader_.GetFrameCount() == 0)
+    {
+      std::cerr << std::format("ERROR::TRAJECTORY: '{}' holds no frames", path.string()) << std::endl;
+      reader_.Close();
+      return false;
+    }
+
+    playhead_ = static_cast<double>(GetFirstStep());
+    target_ = 0;
+    stopping_ = false;
+    residentBegin_ = residentEnd_ = 0;
+    loader_ = std::thread(&TrajectoryPlayer::run, this);
+    return true;
+  }
+
+  void TrajectoryPlayer::Close()
+  {
+    if (!IsOpen())
+      return;
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    targetChanged_.notify_one();
+    loader_.join();
+    reader_.Close();
+  }
+
+  void TrajectoryPlayer::Update(double frameSeconds)
+  {
+    // The step length is only known once the first frame was decoded
+    float stepSeconds = GetFrame().current.stepSeconds;
+    if (!IsOpen() || paused || stepSeconds <= 0.0f)
+      return;
+    Seek(playhead_ + speed * frameSeconds / stepSeconds);
+    if (playhead_ >= static_cast<double>(GetLastStep()))
+      paused = true;
+  }
+
+  void TrajectoryPlayer::Seek(double step)
+  {
+    if (!IsOpen())
+      return;
+    playhead_ = std::clamp(step, static_cast<double>(GetFirstStep()), static_cast<double>(GetLastStep()));
+    // The first frame at or past the playhead, blended from the one before
+    size_t frame = reader_.FindFrame(static_cast<uint64_t>(playhead_));
+    if (static_cast<double>(reader_.GetEntry(frame).step) < playhead_ && frame + 1 < reader_.GetFrameCount())
+      frame++;
+    setTarget(frame);
+  }
+
+  float TrajectoryPlayer::GetAlpha() const
+  {
+    const ReplayFrame &frame = GetFrame();
+    if (frame.current.step <= frame.previousStep)
+      return 1.0f;
+    double alpha = (playhead_ - static_cast<double>(frame.previousStep)) / static_cast<double>(frame.current.step - frame.previousStep);
+    return static_cast<float>(std::clamp(alpha, 0.0, 1.0));
+  }
+
+  void TrajectoryPlayer::setTarget(size_t frame)
+  {
+    {
+      std::lock_guard lock(mutex_);
+      if (target_ == frame)
+        return;
+      target_ = frame;
+    }
+    targetChanged_.notify_one();
+  }
+
+  void TrajectoryPlayer::run()
+  {
+    TrajectoryFrame previous, current;
+    size_t shown = NO_FRAME;
+    std::unique_lock lock(mutex_);
+    while (!stopping_)
+    {
+      size_t target = target_;
+      if (target != shown)
+      {
+        lock.unlock();
+        bool decoded;
+        if (shown != NO_FRAME && target == shown + 1)
+        {
+          // Playing forward only decodes the one new frame
+          std::swap(previous, current);
+          decoded = reader_.ReadFrame(target, current);
+        }
+        else
+        {
+          decoded = (target == 0 || reader_.ReadFrame(target - 1, previous)) && reader_.ReadFrame(target, current);
+        }
+
+        if (decoded)
+        {
+          ReplayFrame &frame = frames_.GetWriteBuffer();
+          frame.current = current;
+          // A frame after the particle count changed has nothing to blend from
+          bool blend = target > 0 && previous.positions.size() == current.positions.size();
+          frame.previousPositions = blend ? previous.positions : current.positions;
+          frame.previousStep = blend ? previous.step : current.step;
+          frames_.Publish();
+        }
+        // A corrupt frame is reported once, not retried until the target moves on
+        shown = decoded ? target : NO_FRAME;
+        lock.lock();
+        if (!decoded)
+          targetChanged_.wait(lock, [&]
+                              { return stopping_ || target_ != target; });
+        continue;
+      }
+
+      lock.unlock();
+      bool complete = readAhead(target);
+      lock.lock();
+      if (complete)
+        targetChanged_.wait(lock, [&]
+                            { return stopping_ || target_ != shown; });
+    }
+  }
+
+  bool TrajectoryPlayer::readAhead(size_t frame)
+  {
+    const MappedFile &file = reader_.GetFile();
+    uint64_t begin = reader_.GetEntry(frame).offset;
+    uint64_t end = std::min<uint64_t>(begin + TRAJECTORY_READAHEAD_BYTES, file.GetSize());
+
+    // Seeking decodes from the keyframe before the target, anything before that can go
+    uint64_t keep = reader_.GetEntry(reader_.FindKeyframe(frame)).offset;
+    if (keep < residentBegin_ || keep > residentEnd_)
+    {
+      file.Release(residentBegin_, residentEnd_ - residentBegin_);
+      residentBegin_ = residentEnd_ = keep;
+    }
+    else if (keep > residentBegin_)
+    {
+      file.Release(residentBegin_, keep - residentBegin_);
+      residentBegin_ = keep;
+    }
+
+    // The hint lets the OS queue the whole window, touching makes sure it is in by the time it is decoded
+    if (residentEnd_ < end)
+      file.Prefetch(residentEnd_, end - residentEnd_);
+    while (residentEnd_ < end)
+    {
+      uint64_t piece = std::min(READ_AHEAD_PIECE, end - residentEnd_);
+      file.Touch(residentEnd_, piece);
+      residentEnd_ += piece;
+      std::lock_guard lock(mutex_);
+      if (stopping_ || target_ != frame)
+        return false;
+    }
+    return true;
+  }
+}
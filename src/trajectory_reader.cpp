@@ -0,0 +1,118 @@
+#include "plpp/trajectory_reader.h"
+
+// Project Includes
+#include "plpp/mapped_file.h"
+#include "plpp/trajectory.h"
+#include "plpp/trajectory_recorder.h"
+
+// C++ Standard Library
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <vector>
+
+namespace PLPP
+{
+  bool TrajectoryReader::Open(const std::filesystem::path &path)
+  {
+    Close();
+    if (!file_.Open(path))
+    {
+      std::cerr << std::format("ERROR::TRAJECTORY: Failed to map '{}'", path.string()) << std::endl;
+      return false;
+    }
+
+    TrajectoryFileHeader header;
+    if (file_.GetSize() >= sizeof(header))
+      std::memcpy(&header, file_.GetData(), sizeof(header));
+    if (file_.GetSize() < sizeof(header) || std::memcmp(header.magic, TrajectoryRecorder::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TrajectoryRecorder::VERSION || header.headerSize < sizeof(header))
+    {
+      std::cerr << std::format("ERROR::TRAJECTORY: '{}' is not a version {} trajectory", path.string(), TrajectoryRecorder::VERSION) << std::endl;
+      Close();
+      return false;
+    }
+
+    uint64_t size = file_.GetSize();
+    if (header.indexOffset >= header.headerSize && header.indexOffset <= size &&
+        header.frameCount <= (size - header.indexOffset) / sizeof(TrajectoryIndexEntry))
+    {
+      index_.resize(header.frameCount);
+      std::memcpy(index_.data(), file_.GetData() + header.indexOffset, index_.size() * sizeof(TrajectoryIndexEntry));
+      TrajectoryFrameHeader frame;
+      bool valid = std::all_of(index_.begin(), index_.end(), [&](const TrajectoryIndexEntry &entry)
+                               { return entry.offset < header.indexOffset && isFrame(entry.offset, frame); });
+      if (valid)
+        return true;
+      index_.clear();
+    }
+
+    // Interrupted recording, the frames up to the one cut off are still good
+    TrajectoryFrameHeader frame;
+    for (uint64_t offset = header.headerSize; isFrame(offset, frame); offset += sizeof(frame) + frame.payloadSize)
+      index_.push_back({offset, frame.step, frame.flags, frame.particleCount});
+    std::cout << std::format("Trajectory {} has no index, found {} frames", path.string(), index_.size()) << std::endl;
+    return true;
+  }
+
+  void TrajectoryReader::Close()
+  {
+    file_.Close();
+    index_.clear();
+    decoder_.Reset();
+    decodedFrame_ = -1;
+  }
+
+  size_t TrajectoryReader::FindFrame(uint64_t step) const
+  {
+    auto next = std::upper_bound(index_.begin(), index_.end(), step, [](uint64_t value, const TrajectoryIndexEntry &entry)
+                                 { return value < entry.step; });
+    return next == index_.begin() ? 0 : static_cast<size_t>(next - index_.begin()) - 1;
+  }
+
+  size_t TrajectoryReader::FindKeyframe(size_t frame) const
+  {
+    while (frame > 0 && !(index_[frame].flags & TRAJECTORY_KEYFRAME))
+      frame--;
+    return frame;
+  }
+
+  bool TrajectoryReader::ReadFrame(size_t frame, TrajectoryFrame &out)
+  {
+    if (frame >= index_.size())
+      return false;
+
+    // Carry on from the decoded frame if no keyframe lies in between
+    size_t first = FindKeyframe(frame);
+    if (decodedFrame_ >= static_cast<int64_t>(first) && decodedFrame_ <= static_cast<int64_t>(frame))
+      first = static_cast<size_t>(decodedFrame_) + 1;
+
+    for (size_t next = first; next <= frame; next++)
+    {
+      TrajectoryFrameHeader header;
+      std::memcpy(&header, file_.GetData() + index_[next].offset, sizeof(header));
+      if (!decoder_.Apply(header, {file_.GetData() + index_[next].offset + sizeof(header), header.payloadSize}))
+      {
+        std::cerr << std::format("ERROR::TRAJECTORY: Frame {} is corrupt", next) << std::endl;
+        decoder_.Reset();
+        decodedFrame_ = -1;
+        return false;
+      }
+      decodedFrame_ = static_cast<int64_t>(next);
+    }
+    decoder_.Read(out);
+    return true;
+  }
+
+  bool TrajectoryReader::isFrame(uint64_t offset, TrajectoryFrameHeader &header) const
+  {
+    uint64_t size = file_.GetSize();
+    if (offset > size || size - offset < sizeof(header))
+      return false;
+    std::memcpy(&header, file_.GetData() + offset, sizeof(header));
+    return header.tag == TrajectoryEncoder::FRAME_TAG && header.payloadSize <= size - offset - sizeof(header);
+  }
+}
@@ -0,0 +1,193 @@
+#include "plpp/trajectory_recorder.h"
+
+// Project Includes
+#include "plpp/constants.h"
+#include "plpp/trajectory.h"
+
+// External Libraries
+#include <glm/glm.hpp>
+
+// C++ Standard Library
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PLPP
+{
+  bool TrajectoryRecorder::Open(const std::filesystem::path &path, int keyframeInterval)
+  {
+    Close();
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_)
+    {
+      std::cerr << std::format("ERROR::TRAJECTORY: Failed to open '{}' for writing", path.string()) << std::endl;
+      return false;
+    }
+
+    // The index is only known once the recording is closed
+    TrajectoryFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(TrajectoryFileHeader);
+    header.keyframeInterval = static_cast<uint32_t>(std::max(keyframeInterval, 1));
+    file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    offset_ = sizeof(header);
+
+    encoder_.keyframeInterval = static_cast<int>(header.keyframeInterval);
+    encoder_.Reset();
+    index_.clear();
+    stopping_ = false;
+    for (auto *counter : {&framesWritten_, &framesDropped_, &keyframesWritten_, &bytesWritten_, &rawBytes_})
+      counter->store(0, std::memory_order_relaxed);
+    writer_ = std::thread(&TrajectoryRecorder::run, this);
+    return true;
+  }
+
+  void TrajectoryRecorder::Close()
+  {
+    if (!IsOpen())
+      return;
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    queued_.notify_one();
+    writer_.join();
+
+    // The index goes after the last frame, then the header is rewritten to point at it
+    TrajectoryFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(TrajectoryFileHeader);
+    header.keyframeInterval = static_cast<uint32_t>(encoder_.keyframeInterval);
+    header.indexOffset = offset_;
+    header.frameCount = index_.size();
+    file_.seekp(static_cast<std::streamoff>(offset_));
+    file_.write(reinterpret_cast<const char *>(index_.data()), index_.size() * sizeof(TrajectoryIndexEntry));
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file_.close();
+    if (!file_)
+      std::cerr << "ERROR::TRAJECTORY: Failed to finish the trajectory file" << std::endl;
+  }
+
+  bool TrajectoryRecorder::reserve(std::unique_lock<std::mutex> &lock)
+  {
+    if (dropWhenBusy && inFlight_ >= TRAJECTORY_STAGING_FRAMES)
+    {
+      framesDropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    finished_.wait(lock, [this]
+                   { return inFlight_ < TRAJECTORY_STAGING_FRAMES; });
+    inFlight_++;
+    return true;
+  }
+
+  bool TrajectoryRecorder::Submit(const TrajectoryFrameView &frame)
+  {
+    if (!IsOpen())
+      return false;
+    std::unique_lock lock(mutex_);
+    if (!reserve(lock))
+      return false;
+    // Fewer frames are in flight than there are copies, one of them is free
+    int index = static_cast<int>(std::find_if(std::begin(copies_), std::end(copies_), [](const FrameCopy &copy)
+                                              { return !copy.inUse; }) -
+                                 std::begin(copies_));
+    FrameCopy &copy = copies_[index];
+    copy.inUse = true;
+    lock.unlock();
+
+    copy.positions.assign(frame.positions.begin(), frame.positions.end());
+    copy.velocities.assign(frame.velocities.begin(), frame.velocities.end());
+    copy.types.assign(frame.types.begin(), frame.types.end());
+    Job job{frame, index, nullptr};
+    job.frame.positions = copy.positions;
+    job.frame.velocities = copy.velocities;
+    job.frame.types = copy.types;
+
+    lock.lock();
+    jobs_.push_back(job);
+    lock.unlock();
+    queued_.notify_one();
+    return true;
+  }
+
+  bool TrajectoryRecorder::SubmitBorrowed(const TrajectoryFrameView &frame, std::atomic<bool> &released)
+  {
+    if (!IsOpen())
+      return false;
+    std::unique_lock lock(mutex_);
+    if (!reserve(lock))
+      return false;
+    released.store(false, std::memory_order_relaxed);
+    jobs_.push_back({frame, -1, &released});
+    lock.unlock();
+    queued_.notify_one();
+    return true;
+  }
+
+  TrajectoryStatistics TrajectoryRecorder::GetStatistics() const
+  {
+    TrajectoryStatistics statistics;
+    statistics.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+    statistics.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    statistics.keyframesWritten = keyframesWritten_.load(std::memory_order_relaxed);
+    statistics.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    statistics.rawBytes = rawBytes_.load(std::memory_order_relaxed);
+    return statistics;
+  }
+
+  void TrajectoryRecorder::run()
+  {
+    std::vector<uint8_t> encoded;
+    while (true)
+    {
+      Job job;
+      {
+        std::unique_lock lock(mutex_);
+        queued_.wait(lock, [this]
+                     { return stopping_ || !jobs_.empty(); });
+        // Whatever is queued when the recording closes is still written
+        if (jobs_.empty())
+          return;
+        job = jobs_.front();
+        jobs_.pop_front();
+      }
+
+      encoded.clear();
+      encoder_.Encode(job.frame, encoded);
+      TrajectoryFrameHeader header;
+      std::memcpy(&header, encoded.data(), sizeof(header));
+      // Done with the particles, the disk write below no longer needs them
+      if (job.released)
+        job.released->store(true, std::memory_order_release);
+      {
+        std::lock_guard lock(mutex_);
+        if (job.copy >= 0)
+          copies_[job.copy].inUse = false;
+        inFlight_--;
+      }
+      finished_.notify_all();
+
+      file_.write(reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+      index_.push_back({offset_, header.step, header.flags, header.particleCount});
+      offset_ += encoded.size();
+
+      framesWritten_.fetch_add(1, std::memory_order_relaxed);
+      if (header.flags & TRAJECTORY_KEYFRAME)
+        keyframesWritten_.fetch_add(1, std::memory_order_relaxed);
+      bytesWritten_.fetch_add(encoded.size(), std::memory_order_relaxed);
+      rawBytes_.fetch_add(2 * sizeof(glm::vec2) * static_cast<uint64_t>(header.particleCount), std::memory_order_relaxed);
+    }
+  }
+}